@@ -1,3 +1,6 @@
+#include "lib/lib.hpp"
+#include "lib/stream_reader.hpp"
+
 #include <algorithm>
 #include <iostream>
 #include <map>
@@ -11,23 +14,18 @@ int main(int argc, char **argv) {
   std::vector<int> l1 {};
   std::vector<int> l2 {};
 
-  while (true) {
-    int x;
-
-    std::cin >> x;
-
-    int y;
-    std::cin >> y;
-
-    if (std::cin.eof()) {
-      break;
+  StreamReader input{StreamReader::from_stdin()};
+  input.for_each_line([&](std::string_view line) {
+    if (line.empty()) {
+      return;
     }
+    auto [x, y] = parse_n_numbers<int, 2>(line);
 
     l1.push_back(x);
     l2.push_back(y);
 
     std::cout << "Line: " << x << " " << y << std::endl;
-  }
+  });
 
   if (false) {
     std::sort(l1.begin(), l1.end());
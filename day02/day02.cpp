@@ -1,3 +1,6 @@
+#include "lib/num_scan.hpp"
+#include "lib/stream_reader.hpp"
+
 #include <algorithm>
 #include <cstring>
 #include <functional>
@@ -6,7 +9,6 @@
 #include <map>
 #include <numeric>
 #include <ostream>
-#include <sstream>
 #include <string>
 #include <vector>
 #include <ranges>
@@ -35,19 +37,16 @@ bool report_safe_dampened(const std::vector<int> &report) {
 }
 
 int main(int argc, char **argv) {
-  std::vector<std::vector<int>> reports{};
-
-  std::string line;
-  while (std::getline(std::cin, line)) {
-    std::istringstream line_stream {line};
-    std::vector<int> report{};
-    std::copy(std::istream_iterator<int>(line_stream), std::istream_iterator<int>(), std::back_insert_iterator(report));
-    // std::cout << "Line: " << line << " " << report.size() << std::endl;
-    reports.push_back(report);
-  }
-
-  std::vector<std::vector<int>> safe_reports;
-  std::copy_if(reports.begin(), reports.end(), std::back_inserter(safe_reports),
-               &report_safe_dampened);
-  std::cout << safe_reports.size() << std::endl;
+  // Reports are checked as they're read; only the current one is kept.
+  StreamReader input{StreamReader::from_stdin()};
+  std::vector<int> report{};
+  size_t safe_reports{0};
+  input.for_each_line([&](std::string_view line) {
+    report.clear();
+    scan_numbers(line, report);
+    if (report_safe_dampened(report)) {
+      ++safe_reports;
+    }
+  });
+  std::cout << safe_reports << std::endl;
 }
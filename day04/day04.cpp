@@ -1,4 +1,9 @@
+#include "lib/line_buffer.hpp"
+#include "lib/row_scan.hpp"
+
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iostream>
@@ -11,6 +16,7 @@
 #include <string>
 #include <vector>
 #include <ranges>
+#include <span>
 /*
 XMAS X  X
 ....  MM
@@ -18,49 +24,57 @@ XMAS X  X
 .... S  S
 */
 int main(int argc, char **argv) {
-  std::vector<std::string> input{};
-  std::string line;
-  while (std::getline(std::cin, line)) {
-    input.push_back(line);
-  };
+  LineBuffer input{LineBuffer::from_stdin()};
   int height = input.size();
   int width = input[0].size();
 
   int result{0};
 
+  // A match starts on an 'X' or 'S': at x for hor/ver/dia1, at x + 3 for dia2.
+  std::vector<uint64_t> x_mask((width + 63) / 64), s_mask((width + 63) / 64);
   for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      if ( x < width - 3 ) {
-        std::string hor{input[y][x + 0], input[y][x + 1],
-                        input[y][x + 2], input[y][x + 3]};
-        if (hor == "XMAS" || hor == "SAMX") {
-          // std::cout << "hor " << y << " " << x << " " << hor << std::endl;
-          ++result;
+    std::span<const char> row{input[y]};
+    grid::scan::equal_mask(row, 'X', x_mask.data());
+    grid::scan::equal_mask(row, 'S', s_mask.data());
+    for (size_t w = 0; w < x_mask.size(); w++) {
+      x_mask[w] |= s_mask[w];
+    }
+    for (size_t w = 0; w < x_mask.size(); w++) {
+      uint64_t starts = x_mask[w] | (x_mask[w] >> 3) | (w + 1 < x_mask.size() ? x_mask[w + 1] << 61 : 0);
+      for (uint64_t bits = starts; bits; bits &= bits - 1) {
+        int x = w * 64 + std::countr_zero(bits);
+        if ( x < width - 3 ) {
+          std::string hor{input[y][x + 0], input[y][x + 1],
+                          input[y][x + 2], input[y][x + 3]};
+          if (hor == "XMAS" || hor == "SAMX") {
+            // std::cout << "hor " << y << " " << x << " " << hor << std::endl;
+            ++result;
+          }
         }
-      }
 
-      if ( y < height - 3 ) {
-        std::string ver{input[y + 0][x], input[y + 1][x],
-                        input[y + 2][x], input[y + 3][x]};
-        if (ver == "XMAS" || ver == "SAMX") {
-          // std::cout << "ver " << y << " " << x << " " << ver << std::endl;
-          ++result;
+        if ( y < height - 3 ) {
+          std::string ver{input[y + 0][x], input[y + 1][x],
+                          input[y + 2][x], input[y + 3][x]};
+          if (ver == "XMAS" || ver == "SAMX") {
+            // std::cout << "ver " << y << " " << x << " " << ver << std::endl;
+            ++result;
+          }
         }
-      }
 
-      if ( (y < height - 3) && (x < width - 3) ) {
-        std::string dia1{""}, dia2{""};
-        for (int ddia = 0; ddia < 4; ddia++) {
-          dia1.push_back(input[y + ddia][x + ddia]);
-          dia2.push_back(input[y + ddia][x + 3 - ddia]);
-        }
-        if (dia1 == "XMAS" || dia1 == "SAMX") {
-          // std::cout << "diaf " << x << " " << y << std::endl;
-          result++;
-        }
-        if (dia2 == "XMAS" || dia2 == "SAMX") {
-          // std::cout << "diar " << x + 3 << " " << y << std::endl;
-          result++;
+        if ( (y < height - 3) && (x < width - 3) ) {
+          std::string dia1{""}, dia2{""};
+          for (int ddia = 0; ddia < 4; ddia++) {
+            dia1.push_back(input[y + ddia][x + ddia]);
+            dia2.push_back(input[y + ddia][x + 3 - ddia]);
+          }
+          if (dia1 == "XMAS" || dia1 == "SAMX") {
+            // std::cout << "diaf " << x << " " << y << std::endl;
+            result++;
+          }
+          if (dia2 == "XMAS" || dia2 == "SAMX") {
+            // std::cout << "diar " << x + 3 << " " << y << std::endl;
+            result++;
+          }
         }
       }
     }
@@ -69,7 +83,11 @@ int main(int argc, char **argv) {
 
   result = 0;
   for (int y = 0; y < height - 2; y++) {
-    for (int x = 0; x < width - 2; x++) {
+    // every X-MAS is centered on an 'A'
+    std::span<const char> center_row{input[y + 1]};
+    for (auto center = grid::scan::find_next(center_row.first(width - 1), 'A', 1); center;
+         center = grid::scan::find_next(center_row.first(width - 1), 'A', *center + 1)) {
+      int x = *center - 1;
 
       std::string dia1{""}, dia2{""};
       for (int ddia = 0; ddia < 3; ddia++) {
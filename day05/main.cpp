@@ -6,41 +6,28 @@
 #include <map>
 #include <numeric>
 #include <ostream>
-#include <regex>
-#include <sstream>
 #include <string>
 #include <vector>
 #include <ranges>
 #include <set>
 #include "lib/lib.hpp"
+#include "lib/mapped_input.hpp"
+#include "lib/parse.hpp"
 
 int main(int argc, char **argv) {
-  std::string line{};
+  MappedInput input{MappedInput::from_stdin()};
   std::map<int, std::set<int>> dependencies{};
   std::vector<std::vector<int>> updates{};
 
-  bool prolog{true};
-  while (std::getline(std::cin, line)) {
-    if (line == "") {
-      prolog = false;
-      continue;
-    }
-    if (prolog) {
-      std::string goes_before, goes_after;
-      std::istringstream stream{line};
-      std::getline(stream, goes_before, '|');
-      std::getline(stream, goes_after, '|');
-      dependencies[std::stoi(goes_after)].insert(std::stoi(goes_before));
-    } else {
-      std::vector<int> pages{};
-      std::istringstream stream{line};
-      std::string page;
-      while (std::getline(stream, page, ',')) {
-        pages.push_back(std::stoi(page));
-      }
-      updates.push_back(pages);
-    }
-  }
+  parse::Parser parser{input.view()};
+  parser.block().lines([&](parse::Parser &rule) {
+    int goes_before = rule.integer<int>();
+    rule.literal("|");
+    dependencies[rule.integer<int>()].insert(goes_before);
+  });
+  parser.block().lines([&](parse::Parser &update) {
+    updates.push_back(update.list(",", &parse::Parser::integer<int>));
+  });
   std::cout << "Rules " << dependencies.size() << std::endl;
 
   std::cout << "Update " << updates.size() << std::endl;
@@ -1,3 +1,11 @@
+#include "lib/grid.hpp"
+#include "lib/grid_index.hpp"
+#include "lib/grid_loader.hpp"
+#include "lib/lib.hpp"
+#include "lib/mapped_input.hpp"
+#include "lib/overlay_grid.hpp"
+#include "lib/progress.hpp"
+
 #include "indicators/block_progress_bar.hpp"
 #include "indicators/cursor_control.hpp"
 
@@ -7,6 +15,7 @@
 #include <set>
 #include <format>
 #include <utility>
+#include <vector>
 #include <cstdlib>
 // #define _XOPEN_SOURCE
 #include <wchar.h>
@@ -18,79 +27,45 @@ enum class MapBlock {
 };
 using enum MapBlock;
 
-enum class Direction : int {
-  Left,
-  Up,
-  Right,
-  Down,
-};
+struct Block {
+  MapBlock m_val{Empty};
 
-using enum Direction;
+  static Block out_of_bounds() { return Block{OutOfBounds}; }
+};
 
 typedef std::pair<int, int> Coord;
-typedef std::map<std::pair<int, int>, MapBlock> Map;
-
-Direction rotateRight(Direction d) {
-  return Direction{(std::to_underlying(d) + 1) % (std::to_underlying(Down) + 1)};
-}
+typedef grid::Grid<Block> Map;
+// The map with one more obstruction, addressed by IndexSpace offset.
+typedef grid::Overlay<std::vector<MapBlock>, uint32_t> WhatIfMap;
 
 void dumpCoord(const Coord c, std::string prefix = "") {
   std::cout << std::format("{}({}, {})\n", prefix == "" ? "" : prefix + ": ", c.first, c.second);
 }
 
-
-Coord stepInDirection(Coord c, Direction d) {
-  switch (d) {
-  case Direction::Left:
-    c.first -= 1;
-    break;
-  case Direction::Right:
-    c.first += 1;
-    break;
-  case Direction::Up:
-    c.second -= 1;
-    break;
-  case Direction::Down:
-    c.second += 1;
-    break;
-  }
-  return c;
-}
-
-MapBlock getBlock(const Map &map, Coord coord) {
-  if (map.contains(coord)) {
-    return map.at(coord);
-  }
-  return OutOfBounds;
-}
-
-typedef void (*TraverseCallback)(Coord guardCoord, Direction guardDirection);
-
 enum class TraverseResult {
   OK, LoopDetected
 };
 
-TraverseResult traverseMap(const Map &map, Coord guardCoord, Direction guardDirection, TraverseCallback cb = NULL) {
-  std::set<std::pair<Coord,Direction>> visited{};
+// Walks the guard until they leave the map or come back to a cell facing the
+// same way. `seen` is scratch space of space.size(), reused between calls.
+TraverseResult traverseMap(const grid::IndexSpace &space, const WhatIfMap &blocks,
+                           grid::GridIndex guard, Dir2D direction, std::vector<uint8_t> &seen) {
+  std::fill(seen.begin(), seen.end(), 0);
+  auto blocked = [&](grid::GridIndex i) { return blocks[i.offset] == Obstruction; };
 
-  while (getBlock(map, guardCoord) != OutOfBounds) {
-    auto visit = make_pair(guardCoord, guardDirection);
-    if (visited.contains(visit)) {
+  while (blocks[guard.offset] != OutOfBounds) {
+    uint8_t bit = 1 << direction.idx();
+    if (seen[guard.offset] & bit) {
       return TraverseResult::LoopDetected;
     }
-    visited.insert(visit);
-    if (cb) {
-      cb(visit.first, visit.second);
-    }
-
-    Coord next = stepInDirection(guardCoord, guardDirection);
+    seen[guard.offset] |= bit;
 
-    while (Obstruction == getBlock(map, next)) {
-      guardDirection = rotateRight(guardDirection);
-      next = stepInDirection(guardCoord, guardDirection);
+    grid::GridIndex next = space.step(guard, direction);
+    while (blocked(next)) {
+      direction = direction.right();
+      next = space.step(guard, direction);
     }
-
-    guardCoord = next;
+    guard = next;
   }
 
   return TraverseResult::OK;
@@ -98,55 +73,46 @@ TraverseResult traverseMap(const Map &map, Coord guardCoord, Direction guardDire
 
 
 int main(int argc, char **argv) {
-  Map map{};
-
-  Coord guardCoord, initialGuardCoord;
-  Direction guardDirection, initialGuardDirection;
-  int x{0}, y{0};
-  char c;
-  while (std::cin.get(c)) {
-    if (c == '\n') {
-      x = 0;
-      ++y;
-      continue;
-    }
-    if (c == '#') {
-      map[std::make_pair(x, y)] = Obstruction;
-    } else if (c == '^') {
-      initialGuardCoord = guardCoord = std::make_pair(x, y);
-      guardDirection = initialGuardDirection = Up;
-      map[std::make_pair(x, y)] = Empty;
-    } else if (c == '.') {
-      map[std::make_pair(x, y)] = Empty;
-    }
-    ++x;
-  }
-
-  int minX{INT_MAX}, maxX{INT_MIN}, minY{INT_MAX}, maxY{INT_MIN};
-  for (auto [x, y] : std::views::keys(map)) {
-    if (x < minX) minX = x;
-    if (x > maxX) maxX = x;
-    if (y < minY) minY = y;
-    if (y > maxX) maxY = y;
+  MappedInput input{MappedInput::from_stdin()};
+  auto parsed = grid::parse_grid(input.view(), grid::CharTable<Block>{}
+                                 .cell('#', Block{Obstruction})
+                                 .cell('.', Block{Empty})
+                                 .marker('^', Block{Empty}));
+  Map map{std::move(parsed.grid)};
+
+  Coord2D guardCoord{};
+  if (auto guard = parsed.marker('^')) {
+    guardCoord = *guard;
   }
-  std::cout << std::format("Map rectangle ({}, {})-({}, {})", minX, minY, maxX, maxY) << std::endl;
-  std::cout << std::format("Initial guard coord ({}, {})\n", guardCoord.first, guardCoord.second);
-
-  std::set<Coord> visited{};
-
-  while (getBlock(map, guardCoord) != OutOfBounds) {
-    // dumpCoord(guardCoord, "Visiting");
-    visited.insert(guardCoord);
 
-    Coord next = stepInDirection(guardCoord, guardDirection);
-    // dumpCoord(guardCoord, "Next candiate");
-
-    while (Obstruction == getBlock(map, next)) {
-      guardDirection = rotateRight(guardDirection);
-      next = stepInDirection(guardCoord, guardDirection);
+  auto [topLeft, bottomRight] = map.bounds();
+  std::cout << std::format("Map rectangle ({}, {})-({}, {})", topLeft.x, topLeft.y, bottomRight.x, bottomRight.y) << std::endl;
+  std::cout << std::format("Initial guard coord ({}, {})\n", guardCoord.x, guardCoord.y);
+
+  grid::IndexSpace space{map.bounds()};
+  std::vector<MapBlock> blocks{space.flatten(map, [](Block b) { return b.m_val; }, OutOfBounds)};
+  const grid::GridIndex initialGuard{space.index(guardCoord)};
+  const Dir2D initialDirection{Dir2D::Up};
+
+  // Cells in the order the guard first reaches them.
+  std::vector<grid::GridIndex> visited{};
+  {
+    std::vector<bool> reached(blocks.size());
+    grid::GridIndex guard{initialGuard};
+    Dir2D direction{initialDirection};
+    while (blocks[guard.offset] != OutOfBounds) {
+      if (!reached[guard.offset]) {
+        reached[guard.offset] = true;
+        visited.push_back(guard);
+      }
+
+      grid::GridIndex next = space.step(guard, direction);
+      while (Obstruction == blocks[next.offset]) {
+        direction = direction.right();
+        next = space.step(guard, direction);
+      }
+      guard = next;
     }
-
-    guardCoord = next;
   }
 
   std::cout << std::format("Visited blocks: {}\n", visited.size());
@@ -157,29 +123,19 @@ int main(int argc, char **argv) {
   int buf_len = std::mbstowcs(buf, "👀", sizeof(buf) - 1);
   std::cout << std::format("Display width from wcswidth {}\n", wcswidth(buf, buf_len));
 
-  using namespace indicators;
-  indicators::BlockProgressBar bar {
-    option::PrefixText{"Looking for loops 👀 "},
-    option::BarWidth{80},
-    option::ForegroundColor{Color::yellow},
-    option::ShowElapsedTime{true},
-    option::ShowRemainingTime{true},
-    option::MaxProgress{visited.size() - 1},
-  };
+  Progress bar{"Looking for loops 👀 ", visited.size() - 1};
 
   int possibleObstructions{0};
 
-  auto restore_cursor = [](void* ) { show_console_cursor(true); };
-  std::unique_ptr<void, decltype(restore_cursor)> cursor_guard{(show_console_cursor(false), (void*)NULL), restore_cursor};
-
-  for (auto extraObstacleCoord :
+  std::vector<uint8_t> seen(blocks.size());
+  for (grid::GridIndex extraObstacle :
        visited | std::views::filter(
-                     [&](const Coord &c) { return c != initialGuardCoord; })) {
+                     [&](grid::GridIndex i) { return i != initialGuard; })) {
     bar.tick();
 
-    auto tmpMap = map;
-    tmpMap[extraObstacleCoord] = Obstruction;
-    switch (traverseMap(tmpMap, initialGuardCoord, initialGuardDirection)) {
+    WhatIfMap whatIf{blocks};
+    whatIf.set(extraObstacle.offset, Obstruction);
+    switch (traverseMap(space, whatIf, initialGuard, initialDirection, seen)) {
     case TraverseResult::LoopDetected:
       possibleObstructions++;
       break;
@@ -187,8 +143,7 @@ int main(int argc, char **argv) {
       break;
     }
   }
-  bar.mark_as_completed();
-  show_console_cursor(true);
+  bar.finish();
 
   std::cout << std::format("Possible obstructions: {}\n", possibleObstructions);
 
@@ -8,8 +8,9 @@
 #include <iterator>
 #include <map>
 #include <numeric>
+#include <optional>
 #include <ostream>
-#include <regex>
+#include <span>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -17,26 +18,78 @@
 #include <ranges>
 #include <set>
 #include "lib/lib.hpp"
+#include "lib/line_buffer.hpp"
+#include "lib/parallel_lines.hpp"
+#include "lib/progress.hpp"
+#include "lib/mapped_input.hpp"
+#include "lib/snapshot.hpp"
+#include "lib/stream_reader.hpp"
 #include <print>
 
 struct Equation {
   long long target = 0;
-  std::vector<long long> operands{};
+  std::span<const long long> operands{};
 };
 
-Equation parse_equation(const std::string &line) {
-  static std::regex num_re{"\\d+"};
+// Appends the operands of "target: operands..." to `operands` and returns the
+// target, or std::nullopt for a line without numbers.
+std::optional<long long> parse_equation(std::string_view line, std::vector<long long> &operands) {
+  NumberScanner<long long> nums{line};
+  std::optional<long long> target = nums.next();
+  if (target) {
+    scan_numbers(nums.rest(), operands);
+  }
+  return target;
+}
+
+// Parsed equations are kept flat, every equation's operands back to back,
+// so they can go into a snapshot as is. Chunks of the input are parsed in
+// parallel into flat arrays of their own, which are then joined with the
+// offsets rebased.
+void parse_equations(std::string_view input, snapshot::Builder &out) {
+  struct Part {
+    std::vector<long long> targets{};
+    std::vector<uint32_t> ends{};
+    std::vector<long long> operands{};
+  };
+  std::vector<std::string_view> chunks = parse::line_chunks(input);
+  std::vector<Part> parts(chunks.size());
+  parse::for_each_chunk(chunks, [&](size_t i, std::string_view chunk) {
+    Part &part = parts[i];
+    for (std::string_view line : LineBuffer::over(chunk)) {
+      if (std::optional<long long> target = parse_equation(line, part.operands)) {
+        part.targets.push_back(*target);
+        part.ends.push_back(part.operands.size());
+      }
+    }
+  });
+
+  std::vector<long long> targets{};
+  std::vector<uint32_t> offsets{0};
+  std::vector<long long> operands{};
+  for (const Part &part : parts) {
+    uint32_t base = operands.size();
+    targets.insert(targets.end(), part.targets.begin(), part.targets.end());
+    for (uint32_t end : part.ends) {
+      offsets.push_back(base + end);
+    }
+    operands.insert(operands.end(), part.operands.begin(), part.operands.end());
+  }
 
-  Equation result{};
+  out.add(targets);
+  out.add(offsets);
+  out.add(operands);
+}
 
-  auto nums = std::sregex_iterator(line.begin(), line.end(), num_re);
-  result.target = std::stoll(nums->str());
-  ++nums;
-  std::vector<int64_t> operands{};
-  std::transform(nums, std::sregex_iterator(),
-                 std::back_inserter(result.operands),
-                 [](const std::smatch &s) { return std::stoll(s.str()); });
+std::vector<Equation> equations_from(const snapshot::Snapshot &snap) {
+  auto targets = snap.section<long long>(0);
+  auto offsets = snap.section<uint32_t>(1);
+  auto operands = snap.section<long long>(2);
 
+  std::vector<Equation> result{};
+  for (size_t i = 0; i < targets.size(); ++i) {
+    result.push_back({targets[i], operands.subspan(offsets[i], offsets[i + 1] - offsets[i])});
+  }
   return result;
 }
 
@@ -110,33 +163,65 @@ void dump_equation(const Equation &eq) {
   std::cout << "\n";
 }
 
+// For piped input without snapshots, each equation is checked for both
+// parts as it's read, so only one line is held in memory at a time.
+int main_streaming() {
+  StreamReader input{StreamReader::from_stdin()};
+  std::vector<long long> operands{};
+  size_t num_equations{0};
+  int64_t sum_1{0}, sum_2{0};
+  input.for_each_line([&](std::string_view line) {
+    operands.clear();
+    std::optional<long long> target = parse_equation(line, operands);
+    if (!target) {
+      return;
+    }
+    Equation eqn{*target, operands};
+    ++num_equations;
+    if (is_equation_resolvable(eqn)) {
+      sum_1 += eqn.target;
+    }
+    if (is_equation_resolvable_2(eqn)) {
+      sum_2 += eqn.target;
+    }
+  });
+  std::println("Total number of equations - {}", num_equations);
+  std::println("Result (part 1) {}", sum_1);
+  std::println("Result (part 2) {}", sum_2);
+  return 0;
+}
+
 int main(int argc, char **argv) {
-  std::string line;
-  std::vector<Equation> eqns;
-  while (std::getline(std::cin, line)) {
-    eqns.push_back(parse_equation(line));
+  if (!snapshot::enabled() && !MappedInput::stdin_is_mappable()) {
+    return main_streaming();
   }
+
+  MappedInput input{MappedInput::from_stdin()};
+  auto snap = snapshot::cached("day07.v1", input.view(), [&](snapshot::Builder &out) {
+    parse_equations(input.view(), out);
+  });
+  std::vector<Equation> eqns{equations_from(snap)};
   std::println("Total number of equations - {}", eqns.size());
 
-  auto bar = make_bar("Detecting equations (base 2) 👀 "s, eqns.size());
+  Progress bar{"Detecting equations (base 2) 👀 ", eqns.size()};
   int64_t sum_1{0};
   for (auto eqn : eqns) {
-    bar->tick();
+    bar.tick();
     if (is_equation_resolvable(eqn)) {
       sum_1 += eqn.target;
     }
   }
-  bar.reset();
+  bar.finish();
   std::println("Result (part 1) {}", sum_1);
 
-  auto bar_2 = make_bar("Detecting equations (base 2) 👀 "s, eqns.size());
+  Progress bar_2{"Detecting equations (base 2) 👀 ", eqns.size()};
   int64_t sum_2{0};
   for (auto eqn : eqns) {
-    bar_2->tick();
+    bar_2.tick();
     if (is_equation_resolvable_2(eqn)) {
       sum_2 += eqn.target;
     }
   }
-  bar_2.reset();
+  bar_2.finish();
   std::println("Result (part 2) {}", sum_2);
 }
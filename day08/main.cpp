@@ -1,4 +1,6 @@
 #include "lib/coord.h"
+#include "lib/coord_batch.hpp"
+#include "lib/parallel_grid.hpp"
 
 #include "indicators/termcolor.hpp"
 
@@ -40,11 +42,17 @@ int main(int argc, char **argv) {
 
   std::cout << "\n";
 
-  for (int y = 0; y <= maxCoord.y; y++) {
+  std::pair<Coord2D, Coord2D> bounds{{0, 0}, maxCoord};
+  std::vector<std::string> rows(maxCoord.y + 1, std::string(maxCoord.x + 1, '.'));
+  grid::parallel_for_rows(bounds, [&](int y) {
     for (int x = 0; x <= maxCoord.x; x++) {
-      std::cout << (antenna_at.contains({x, y}) ? antenna_at[{x, y}] : '.' );
+      if (auto it = antenna_at.find({x, y}); it != antenna_at.end()) {
+        rows[y][x] = it->second;
+      }
     }
-    std::cout << "\n";
+  });
+  for (const auto &row : rows) {
+    std::cout << row << "\n";
   }
 
   auto withinBound = [&](Coord2D c) {
@@ -57,7 +65,7 @@ int main(int argc, char **argv) {
   std::println("Max coord - {}, {}", maxCoord.x, maxCoord.y);
   std::println("Within bound test {}", true == withinBound({5, 5}));
 
-  std::map<Coord2D, int> antinodes;
+  grid::BitGrid antinodes{maxCoord.x + 1, maxCoord.y + 1};
 
   // for (const auto &[freq, coords] : antennas) {
   //   std::println("Processing frequency {} - {} antennas", freq, coords.size());
@@ -81,42 +89,56 @@ int main(int argc, char **argv) {
 
   for (const auto &[freq, coords] : antennas) {
     std::println("Processing frequency {} - {} antennas", freq, coords.size());
-    for (int i = 0; i < coords.size() - 1; i++) {
-      for (int j = i + 1; j < coords.size(); j++) {
-        Coord2D j_coord = coords[j];
-        Coord2D i_coord = coords[i];
 
-        Coord2D delta = j_coord - i_coord;
-
-        while (withinBound(i_coord)) {
-          antinodes[i_coord] = 1;
-          i_coord -= delta;
-        }
+    // Two walkers per antenna pair, each starting on one antenna and heading
+    // away from the other; they mark every cell they pass until they leave
+    // the map, and all of them step together.
+    CoordBatch walkers{}, steps{};
+    for (int i = 0; i < coords.size(); i++) {
+      for (int j = i + 1; j < coords.size(); j++) {
+        Coord2D delta = coords[j] - coords[i];
+        walkers.push_back(coords[i]);
+        steps.push_back(Coord2D{} - delta);
+        walkers.push_back(coords[j]);
+        steps.push_back(delta);
+      }
+    }
 
-        while (withinBound(j_coord)) {
-          antinodes[j_coord] = 1;
-          j_coord += delta;
-        }
+    while (true) {
+      CoordBatch::mask_t inside = walkers.within_bounds({0, 0}, maxCoord);
+      if (std::ranges::none_of(inside, [](uint64_t w) { return w != 0; })) {
+        break;
       }
+      walkers.scatter(antinodes, inside);
+      walkers.add(steps);
     }
   }
 
-  std::println("Antinodes count {}", antinodes.size());
+  std::println("Antinodes count {}", antinodes.count());
 
-  for (int y = 0; y <= maxCoord.y; y++) {
+  // Lookups run in parallel; only the printing, which needs the colours,
+  // is left serial.
+  std::vector<std::vector<bool>> highlight(maxCoord.y + 1);
+  grid::parallel_for_rows(bounds, [&](int y) {
+    highlight[y].assign(maxCoord.x + 1, false);
     for (int x = 0; x <= maxCoord.x; x++) {
       Coord2D cur{x, y};
+      bool is_antinode = antinodes[cur];
+      if (auto it = antenna_at.find(cur); it != antenna_at.end()) {
+        rows[y][x] = it->second;
+        highlight[y][x] = is_antinode;
+      } else {
+        rows[y][x] = is_antinode ? '#' : '.';
+      }
+    }
+  });
 
-      if (antenna_at.contains(cur)) {
-        if (antinodes.contains({x, y})) {
-          std::cout << termcolor::red << antenna_at[cur] << termcolor::reset;
-        } else {
-          std::cout << antenna_at[cur];
-        }
-      } else if (antinodes[{x, y}] > 0) {
-        std::cout << '#';
+  for (int y = 0; y <= maxCoord.y; y++) {
+    for (int x = 0; x <= maxCoord.x; x++) {
+      if (highlight[y][x]) {
+        std::cout << termcolor::red << rows[y][x] << termcolor::reset;
       } else {
-        std::cout << '.';
+        std::cout << rows[y][x];
       }
     }
     std::cout << "\n";
@@ -1,4 +1,5 @@
 #include "lib/coord.h"
+#include "lib/coord_set.hpp"
 #include "indicators/termcolor.hpp"
 #include <algorithm>
 #include <chrono>
@@ -41,10 +42,10 @@ std::tuple<Coord2D, Coord2D> bounding_rect(const HeightMap &heights) {
 
 
 std::pair<int, int> trailhead_score(Coord2D root, const HeightMap &heights) {
-  std::set<Coord2D> visited{};
+  CoordSet visited{};
   std::queue<std::pair<Coord2D, int>> queue;
-  std::set<Coord2D> queued_coords{};
-  std::set<Coord2D> climaxes{};
+  CoordSet queued_coords{};
+  CoordSet climaxes{};
   int score = 0;
 
   auto render_path = [&]() {
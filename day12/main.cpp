@@ -1,4 +1,8 @@
 #include "lib/coord.h"
+#include "lib/coord_set.hpp"
+#include "lib/parallel_grid.hpp"
+#include "lib/profile.hpp"
+#include "lib/stencil.hpp"
 
 #include "indicators/termcolor.hpp"
 
@@ -191,27 +195,20 @@ struct GardenMap {
 
   void place_fences() {
 
-    for (int y = minCoord.y; y <= maxCoord.y; y++) {
-      cells.at({minCoord.x, y}).border_left = true;
-      for (int x = minCoord.x; x < maxCoord.x; x++) {
-        if (cells.at({x, y}).region->crop != cells.at({x+1, y}).region->crop) {
-          cells.at({x, y}).border_right = true;
-          cells.at({x+1, y}).border_left = true;
-        }
-      }
-      cells.at({maxCoord.x, y}).border_right = true;
-    }
-
-    for (int x = minCoord.x; x <= maxCoord.x; x++) {
-      cells.at({x, minCoord.y}).border_up = true;
-      for (int y = minCoord.y; y < maxCoord.y; y++) {
-        if (cells.at({x, y}).region->crop != cells.at({x, y+1}).region->crop) {
-          cells.at({x, y}).border_down = true;
-          cells.at({x, y+1}).border_up = true;
-        }
+    // Each row only writes its own cells and reads its neighbours' crops.
+    grid::parallel_for_rows(std::make_pair(minCoord, maxCoord), [&](int y) {
+      auto differs = [&](const Cell &cell, Coord2D other) {
+        auto it = cells.find(other);
+        return it == cells.end() || it->second.region->crop != cell.region->crop;
+      };
+      for (int x = minCoord.x; x <= maxCoord.x; x++) {
+        Cell &cell = cells.at({x, y});
+        cell.border_left = differs(cell, {x - 1, y});
+        cell.border_right = differs(cell, {x + 1, y});
+        cell.border_up = differs(cell, {x, y - 1});
+        cell.border_down = differs(cell, {x, y + 1});
       }
-      cells.at({x, maxCoord.y}).border_down = true;
-    }
+    });
 
     int fence_id_counter{};
     for (int y = minCoord.y; y <= maxCoord.y; y++) {
@@ -282,14 +279,19 @@ struct GardenMap {
       global_queue.insert(coord);
     }
 
+    // reused between flood fills so their buffers are only allocated once
+    std::vector<Coord2D> local_queue{};
+    CoordSet visited{};
+
     while (!global_queue.empty()) {
       Coord2D coord = *global_queue.begin();
       global_queue.erase(global_queue.begin());
 
       Region* region = cells.at(coord).region;
 
-      std::vector<Coord2D> local_queue{coord.up(), coord.down(), coord.left(), coord.right()};
-      std::set<Coord2D> visited{};
+      local_queue.clear();
+      visited.clear();
+      stencil::Neighbours4::for_each(coord, [&](Coord2D n) { local_queue.push_back(n); });
 
       while (!local_queue.empty()) {
         Coord2D coord = local_queue.back();
@@ -315,10 +317,7 @@ struct GardenMap {
           continue;
         }
 
-        local_queue.push_back(coord.up());
-        local_queue.push_back(coord.down());
-        local_queue.push_back(coord.left());
-        local_queue.push_back(coord.right());
+        stencil::Neighbours4::for_each(coord, [&](Coord2D n) { local_queue.push_back(n); });
 
         // update region in every cell
         std::ranges::for_each(other_region->cells, [&](auto &cell) {
@@ -357,6 +356,7 @@ int main(int argc, char **argv) {
   std::string line;
   GardenMap map{};
   {
+    TRACE_PHASE("parse");
     int y{0};
     while (std::getline(std::cin, line)) {
       int x{0};
@@ -367,9 +367,20 @@ int main(int argc, char **argv) {
   if (auto err = map.validate()) {
     throw std::logic_error(err.value());
   }
-  map.place_fences();
-  map.join_regions();
-  map.render();
+  {
+    TRACE_PHASE("place_fences");
+    map.place_fences();
+  }
+  {
+    TRACE_PHASE("join_regions");
+    map.join_regions();
+  }
+  {
+    TRACE_PHASE("render");
+    map.render();
+  }
+
+  TRACE_PHASE("score");
 
   int64_t total{}, total2{};
   for (Region &region : std::views::values(map.regions)) {
@@ -1,11 +1,12 @@
 #include "lib/lib.hpp"
-#include <cctype>
+#include "lib/mapped_input.hpp"
+#include "lib/parse.hpp"
 #include <format>
 #include <iostream>
 #include <iterator>
 #include <sstream>
 #include <stdexcept>
-#include <streambuf>
+#include <string_view>
 #include <vector>
 #include <print>
 
@@ -165,110 +166,47 @@ struct std::formatter<ClawMachine, char> {
 
 
 
-struct MachineParser {
-  struct Error : std::runtime_error {
-    template<class... Args>
-    Error(int line_no, int col_no, std::format_string<Args...> fmt, Args&&... args) :
-      std::runtime_error(std::format("Error at line {}/col {} - ", line_no, col_no) + std::format(fmt, args...)) {}
+ClawMachine parse_machine(parse::Parser &p) {
+  p.literal("Button A: X+");
+  Num a_dx = p.integer<Num>();
+  p.literal(", Y+");
+  Num a_dy = p.integer<Num>();
+  p.end_of_line();
+  p.literal("Button B: X+");
+  Num b_dx = p.integer<Num>();
+  p.literal(", Y+");
+  Num b_dy = p.integer<Num>();
+  p.end_of_line();
+  p.literal("Prize: X=");
+  Num target_x = p.integer<Num>();
+  p.literal(", Y=");
+  Num target_y = p.integer<Num>();
+  p.end_of_line();
+  return ClawMachine {
+    .a_dx = a_dx,
+    .a_dy = a_dy,
+    .b_dx = b_dx,
+    .b_dy = b_dy,
+    .target_x = target_x,
+    .target_y = target_y,
   };
+}
 
-  std::string_view input, rest;
-
-  int line_no{1}, col_no{0};
-
-  MachineParser(std::string_view input) : input(input), rest(input) {}
-
-  void update_counters(std::string_view s) {
-    for (char c: s) {
-      if ( c == '\n' ) {
-        ++line_no;
-        col_no = 0;
-      }
-    }
-  }
-
-  template<class... Args>
-  [[noreturn]] void handle_error(std::format_string<Args...> fmt, Args&&... args) {
-    throw Error(line_no, col_no, fmt, args...);
-  }
-
-  void p_string(std::string_view expected) {
-    auto got = rest.substr(0, expected.size());
-    if (got == expected) {
-      update_counters(got);
-      rest.remove_prefix(got.size());
-    } else {
-      handle_error("Expected '{}', got '{}'", expected, got);
-    }
-  }
-
-  Num p_int() {
-    int chars_used{};
-    Num result{};
-    while (isdigit(rest[chars_used])) {
-      result = result * 10 + (rest[chars_used] - '0');
-      ++chars_used;
-    }
-    if (!chars_used) {
-      handle_error("No int found");
-    }
-    rest.remove_prefix(chars_used);
-    col_no += chars_used;
-    return result;
-  }
-
-  void p_whitespace() {
-    int chars_used{};
-    while (isspace(rest[chars_used])) {
-      if (rest[chars_used] == '\n') {
-        col_no = 0;
-        ++line_no;
-      }
-      ++chars_used;
-    }
-    rest.remove_prefix(chars_used);
-  }
-
-  ClawMachine p_machine() {
-    p_string("Button A: X+");
-    Num a_dx = p_int();
-    p_string(", Y+");
-    Num a_dy = p_int();
-    p_whitespace();
-    p_string("Button B: X+");
-    Num b_dx = p_int();
-    p_string(", Y+");
-    Num b_dy = p_int();
-    p_whitespace();
-    p_string("Prize: X=");
-    Num target_x = p_int();
-    p_string(", Y=");
-    Num target_y = p_int();
-    p_whitespace();
-    return ClawMachine {
-      .a_dx = a_dx,
-      .a_dy = a_dy,
-      .b_dx = b_dx,
-      .b_dy = b_dy,
-      .target_x = target_x,
-      .target_y = target_y,
-    };
-  }
-
-  std::vector<ClawMachine> p_machines() {
-    std::vector<ClawMachine> result{};
-    while (!rest.empty()) {
-      result.push_back(p_machine());
+std::vector<ClawMachine> parse_machines(std::string_view input) {
+  std::vector<ClawMachine> result{};
+  parse::Parser parser{input};
+  parser.blocks([&](parse::Parser &block) {
+    result.push_back(parse_machine(block));
+    if (!block.at_end()) {
+      block.fail("Unexpected '{}'", block.rest());
     }
-    return result;
-  }
-};
+  });
+  return result;
+}
 
 int main(int argc, char **argv) {
-  std::string input(std::istreambuf_iterator<char>(std::cin), {});
-
-  MachineParser parser{input};
-  auto machines = parser.p_machines();
+  MappedInput input{MappedInput::from_stdin()};
+  auto machines = parse_machines(input.view());
   std::println("Input size {}", machines.size());
 
   Num simple_cost{}, big_cost{};
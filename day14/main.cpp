@@ -1,48 +1,27 @@
 #include "lib/lib.hpp"
 #include "lib/coord.h"
+#include "lib/coord_batch.hpp"
+#include "lib/parallel_lines.hpp"
+#include "lib/parse.hpp"
+#include "lib/mapped_input.hpp"
+#include "lib/snapshot.hpp"
 #include <iostream>
 #include <numeric>
-#include <regex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <ranges>
 #include <vector>
 #include <print>
 
 typedef int Num;
 
-std::vector<Num> extract_signed_numbers(const std::string &s) {
-  std::regex re{"(-?\\d+)"};
-  std::vector<Num> result{};
-  auto numbers_begin = std::sregex_iterator(s.begin(), s.end(), re);
-  auto numbers_end = std::sregex_iterator();
-  for (auto it = numbers_begin; it != numbers_end; ++it) {
-    result.push_back(std::stol(it->str()));
-  }
-  return result;
-}
-
 struct Robot {
   Coord2D c;
   Coord2D v;
   Coord2D bounds;
 
-  Coord2D coord_at(int seconds) {
-    Coord2D result;
-    result.x = c.x + v.x * seconds;
-    while (result.x < 0) {
-      result.x += bounds.x;
-    }
-    result.y = c.y + v.y * seconds;
-    while (result.y < 0) {
-      result.y += bounds.y;
-    }
-    result.x %= bounds.x;
-    result.y %= bounds.y;
-    return result;
-  }
-
-  std::optional<int> quadrant_at(int seconds) {
-    Coord2D cur = coord_at(seconds);
+  static std::optional<int> quadrant_of(Coord2D cur, Coord2D bounds) {
     if (cur.x == (bounds.x / 2) || cur.y == (bounds.y / 2)) {
       return {};
     }
@@ -54,27 +33,45 @@ struct Robot {
   }
 };
 
+void parse_robots(std::string_view input, snapshot::Builder &out) {
+  parse::Parser parser{input};
+  auto [width, height] = parse_n_numbers<Num, 2>(parser.line());
+  Coord2D bounds{width, height};
+
+  auto robots = parse::parse_lines<Robot>(parser.rest(), [&](std::string_view line, std::vector<Robot> &robots) {
+    if (line.empty()) {
+      return;
+    }
+    auto [x, y, vx, vy] = parse_n_numbers<Num, 4>(line);
+    robots.emplace_back(Coord2D{x, y}, Coord2D{vx, vy}, bounds);
+  });
+
+  out.add_value(bounds);
+  out.add(robots);
+}
+
 int main(int argc, char **argv) {
-  std::string line;
-  std::getline(std::cin, line);
-  auto whl = extract_signed_numbers(line);
-  Num width{whl[0]}, height{whl[1]};
+  MappedInput input{MappedInput::from_stdin()};
+  auto snap = snapshot::cached("day14.v1", input.view(), [&](snapshot::Builder &out) {
+    parse_robots(input.view(), out);
+  });
+  auto [width, height] = snap.value<Coord2D>(0);
   std::println("Field size {}x{}", width, height);
 
-  std::vector<Robot> robots;
-  while (std::getline(std::cin, line)) {
-    auto nums = extract_signed_numbers(line);
-    robots.emplace_back(Coord2D{nums[0], nums[1]}, Coord2D{nums[2], nums[3]},
-                        Coord2D{width, height});
+  std::span<const Robot> robots = snap.section<Robot>(1);
+
+  Coord2D bounds{width, height};
+  CoordBatch start{}, velocity{};
+  for (const Robot &robot : robots) {
+    start.push_back(robot.c);
+    velocity.push_back(robot.v);
   }
 
   std::vector<int> quad_count(4, 0);
-  std::map<Coord2D, int> occupied{};
-  for (auto robot : robots) {
-    Coord2D after_100 = robot.coord_at(100);
-    occupied[after_100]++;
-    // std::println("{}", robot.coord_at(100));
-    robot.quadrant_at(100).and_then([&](int quadrant) {
+  CoordBatch after_100{velocity};
+  after_100.mul_scalar(100).add(start).wrap_mod(bounds);
+  for (size_t i = 0; i < after_100.size(); ++i) {
+    Robot::quadrant_of(after_100[i], bounds).and_then([&](int quadrant) {
       quad_count[quadrant]++;
       return std::optional<int>{};
     });
@@ -83,20 +80,16 @@ int main(int argc, char **argv) {
   std::println("{}", std::accumulate(quad_count.begin(), quad_count.end(), 1,
                                      std::multiplies<int>()));
 
+  grid::BitGrid occupied{width, height};
+  CoordBatch positions{start};
+  positions.wrap_mod(bounds);
   int step{};
   while (true) {
-    std::map<Coord2D, int> occupied{};
-    for (auto robot : robots) {
-      Coord2D after = robot.coord_at(step);
-      if (occupied.contains(after)) {
-        goto outer_end;
-      }
-      occupied[after]++;
-      // std::println("{}", robot.coord_at(100));
-      robot.quadrant_at(100).and_then([&](int quadrant) {
-        quad_count[quadrant]++;
-        return std::optional<int>{};
-      });
+    occupied.clear();
+    if (positions.scatter(occupied) > 0) {
+      positions.add(velocity).wrap_mod(bounds);
+      ++step;
+      continue;
     }
 
     std::println("No collisions at {}", step);
@@ -110,14 +103,12 @@ int main(int argc, char **argv) {
         if (x == width / 2) {
           std::cout << ' ';
         } else if (occupied[{x, y}]) {
-          std::cout << occupied[{x, y}];
+          std::cout << 1;
         } else {
           std::cout << '.';
         }
       }
       std::cout << "\n";
     }
-  outer_end:
-    ++step;
   }
 }
@@ -2,6 +2,10 @@
 #include "lib/color.h"
 #include "lib/debug.hpp"
 #include "lib/lib.hpp"
+#include "lib/line_buffer.hpp"
+#include "lib/parallel_grid.hpp"
+#include "lib/progress.hpp"
+#include "lib/tiled_grid.hpp"
 #include <chrono>
 #include <climits>
 #include <cstdint>
@@ -11,7 +15,9 @@
 #include <istream>
 #include <map>
 #include <set>
+#include <span>
 #include <stdexcept>
+#include <string_view>
 #include <thread>
 #include <utility>
 #include <iterator>
@@ -135,7 +141,7 @@ MapClass mk_map(typename MapClass::parse_input_t in) {
 template <class Cell> class Map2D {
 protected:
   using cell_type_t = Cell;
-  using cell_storage_t = std::map<Coord2D, Cell>;
+  using cell_storage_t = grid::TiledGrid<Cell>;
 
   cell_storage_t m_map;
   Coord2D m_min_coord{INT_MAX, INT_MAX}, m_max_coord{INT_MIN, INT_MIN};
@@ -146,9 +152,9 @@ public:
   }
 
   using stencil_t = std::set<Coord2D>;
-  using slice_t = cell_storage_t;
+  using slice_t = std::map<Coord2D, Cell>;
 
-  using parse_input_t = const std::vector<std::string>&;
+  using parse_input_t = std::span<const std::string_view>;
   template<class MapClass> friend MapClass mk_map(typename MapClass::parse_input_t in);
 
   using annotation_t = std::function<std::string(const Cell&)>;
@@ -156,10 +162,11 @@ public:
 
   Coord2D top_left_coord() const { return m_min_coord; }
   Coord2D bottom_right_coord() const { return m_max_coord; }
+  std::pair<Coord2D, Coord2D> bounds() const { return {m_min_coord, m_max_coord}; }
 
   void merge(slice_t &slice) {
     for(auto pair: slice) {
-      m_map[pair.first] = pair.second;
+      m_map.set(pair.first, pair.second);
     }
   }
 
@@ -179,7 +186,7 @@ public:
       }
       Coord2D delta_in_target_frame = cur_target - source;
       bool target_covered_by_stencil = stencil.contains(delta_in_target_frame);
-      Cell target_cell_value{target_covered_by_stencil ? default_value : m_map[cur_target]};
+      Cell target_cell_value{target_covered_by_stencil ? default_value : m_map.at(cur_target)};
 
       DDUMP(DEBUG_STENCIL, cur_source);
       DDUMP(DEBUG_STENCIL, cur_target);
@@ -187,21 +194,21 @@ public:
       DDUMP(DEBUG_STENCIL, target_covered_by_stencil);
       DDUMP(DEBUG_STENCIL, target_cell_value.str());
 
-      if (!test(m_map[cur_source], target_cell_value)) {
+      if (!test(m_map.at(cur_source), target_cell_value)) {
         DPRINT(DEBUG_STENCIL, "Test failed for {}", cur_source);
         return false;
       }
-      assignments.push_back({cur_target, m_map[cur_source]});
+      assignments.push_back({cur_target, m_map.at(cur_source)});
       clears.insert(cur_source);
     }
 
     for (auto upd: assignments) {
       auto [coord, value] = upd;
       clears.erase(coord);
-      m_map[coord] = value;
+      m_map.set(coord, value);
     }
     for (auto clr: clears) {
-      m_map[clr] = default_value;
+      m_map.set(clr, default_value);
     }
     return true;
   }
@@ -233,7 +240,7 @@ protected:
           throw std::runtime_error(std::format("Can't parse char '{}'", c));
         }
         for (Cell c: parse_result.value()) {
-          m_map[{x, y}] = c;
+          m_map.set({x, y}, c);
           m_max_coord.maybe_update_upper_boundary({x, y});
           ++x;
         }
@@ -294,8 +301,8 @@ public:
     if (!coord.within_bounds(m_min_coord, m_max_coord)) {
       throw std::runtime_error(std::format("Can't move robot to a position {} outside of bounds {}-{}", coord, m_min_coord, m_max_coord));
     }
-    if (m_map[coord] != WideCell::Empty) {
-      throw std::runtime_error(std::format("Can't move robot to a non-empty position {} containing '{}'", coord, m_map[coord].str()));
+    if (m_map.at(coord).m_val != WideCell::Empty) {
+      throw std::runtime_error(std::format("Can't move robot to a non-empty position {} containing '{}'", coord, m_map.at(coord).str()));
     }
     m_robot_coord = coord;
   }
@@ -306,11 +313,11 @@ public:
 
   GPS gps_all_boxes() const {
     GPS result{};
-    for (auto pair: m_map) {
-      if (pair.second == WideCell::BoxLeft) {
-        result += gps(pair.first);
+    m_map.for_each([&](Coord2D c, const WideCell &cell) {
+      if (cell.m_val == WideCell::BoxLeft) {
+        result += gps(c);
       }
-    }
+    });
     return result;
   }
 
@@ -444,29 +451,32 @@ struct WideSimulator {
     int box_count{}, broken_box_count{}, wall_count{}, empty_count{};
   };
   ValidationResult validate_map() const {
-    ValidationResult result{};
-    Coord2D tl{map.top_left_coord()}, br{map.bottom_right_coord()};
-    for (int y = tl.y; y <= br.y; ++y) {
-      for (int x = tl.x; x <= br.x; ++x) {
-        switch (map[{x, y}].m_val) {
-        case WideCell::Wall: ++result.wall_count; break;
-        case WideCell::Empty: ++result.empty_count; break;
-        case WideCell::BoxLeft:
-          if (map[Coord2D{x, y}.in_dir(Dir2D::Right)] == WideCell::BoxRight) {
-            ++result.box_count;
-          } else {
-            ++result.broken_box_count;
-          }
-          break;
-        case WideCell::BoxRight:
-          if (map[Coord2D{x, y}.in_dir(Dir2D::Left)] != WideCell::BoxLeft) {
-            ++result.broken_box_count;
-          }
-          break;
+    auto tally = [&](ValidationResult result, Coord2D c, WideCell cell) {
+      switch (cell.m_val) {
+      case WideCell::Wall: ++result.wall_count; break;
+      case WideCell::Empty: ++result.empty_count; break;
+      case WideCell::BoxLeft:
+        if (map[c.in_dir(Dir2D::Right)] == WideCell::BoxRight) {
+          ++result.box_count;
+        } else {
+          ++result.broken_box_count;
+        }
+        break;
+      case WideCell::BoxRight:
+        if (map[c.in_dir(Dir2D::Left)] != WideCell::BoxLeft) {
+          ++result.broken_box_count;
         }
+        break;
       }
-    }
-    return result;
+      return result;
+    };
+    auto combine = [](ValidationResult a, ValidationResult b) {
+      return ValidationResult{
+        a.box_count + b.box_count, a.broken_box_count + b.broken_box_count,
+        a.wall_count + b.wall_count, a.empty_count + b.empty_count,
+      };
+    };
+    return grid::parallel_reduce_cells(map, ValidationResult{}, tally, combine);
   }
 
   bool try_push_box_h(Coord2D coord, Dir2D instr, WideRobotMap::slice_t &update) {
@@ -598,7 +608,8 @@ struct WideSimulator {
       map.render({});
     });
 
-    auto bar = (!DEBUG && visualize) ? make_bar("Running instructions 🏃 ", instructions.size()) : nullptr;
+    // Drawn by hand between frames, the map render owns the cursor.
+    auto bar = (!DEBUG && visualize) ? std::make_unique<Progress>("Running instructions 🏃 ", instructions.size(), 0ms) : nullptr;
 
     if (!DEBUG && visualize) {
       cls();
@@ -643,6 +654,7 @@ struct WideSimulator {
         if constexpr (!DEBUG) {
           std::print("\033[1;1H");
           bar->tick();
+          bar->draw();
           std::print("\033[3;1H\033[0m");
         }
         map.render(anns);
@@ -862,10 +874,9 @@ std::ostream& operator<<(std::ostream& os, Map::Cell c) {
   return os;
 }
 
-std::vector<Dir2D> parse_instructions(std::istream& in) {
-  std::string line;
+std::vector<Dir2D> parse_instructions(std::span<const std::string_view> lines) {
   std::vector<Dir2D> result;
-  while (std::getline(in, line)) {
+  for (std::string_view line : lines) {
     for (char c: line) {
       result.push_back(parse_direction(c));
     }
@@ -956,18 +967,10 @@ std::pair<Map, Coord2D> simulate(const Map &initial_map, Coord2D robot_coord, st
 
 
 int main(int argc, char **argv) {
-  std::vector<std::string> map_input{};
-  std::string line;
-
-  while (getline(std::cin, line)) {
-    if (line == "") {
-      break;
-    }
-    map_input.push_back(line);
-  }
-  auto instructions = parse_instructions(std::cin);
+  LineBuffer input{LineBuffer::from_stdin()};
+  auto instructions = parse_instructions(input.after_blank());
 
-  auto map = mk_map<WideRobotMap>(map_input);
+  auto map = mk_map<WideRobotMap>(input.until_blank());
 
   auto simulation = WideSimulator{
     .map = map,
@@ -1,9 +1,16 @@
+#include "lib/bitgrid.hpp"
+#include "lib/compact_coord.hpp"
 #include "lib/grid.hpp"
+#include "lib/grid_index.hpp"
+#include "lib/grid_loader.hpp"
 #include "lib/lib.hpp"
+#include "lib/mapped_input.hpp"
+#include <array>
 #include <bits/ranges_algo.h>
 #include <list>
 #include <numeric>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -32,46 +39,58 @@ public:
 
 using Grid = grid::Grid<Cell>;
 
-std::tuple<Grid, Coord2D, Coord2D> parse_input(const std::vector<std::string> &input) {
-  assert(input.size() > 3);
-  assert(input[0].size() > 3);
-  for (auto in: input) {
-    assert(in.size() == input[0].size());
-  }
+std::tuple<Grid, Coord2D, Coord2D> parse_input(std::string_view input) {
+  auto table = grid::CharTable<Cell>{}
+    .cell('#', Cell::wall())
+    .cell('.', Cell::empty())
+    .marker('S', Cell::empty())
+    .marker('E', Cell::empty());
 
-  std::optional<Coord2D> start{}, target{};
-  Grid grid(input[0].size(), input.size());
-
-  for (int y = 0; y < input.size(); ++y) {
-    for (int x = 0; x < input[y].size(); ++x) {
-      Coord2D c{x, y};
-      switch (input[y][x]) {
-      case '#': grid.set(c, Cell::wall()); break;
-      case '.': break;
-      case 'S': start = c; break;
-      case 'E': target = c; break;
-      default:
-        throw std::runtime_error(std::format("Unexpected char {}", static_cast<char>(input[y][x])));
-      }
-    }
-  }
+  auto parsed = grid::parse_grid(input, table);
+  assert(parsed.grid.height() > 3);
+  assert(parsed.grid.width() > 3);
+
+  std::optional<Coord2D> start{parsed.marker('S')}, target{parsed.marker('E')};
   if (!start) throw std::runtime_error("No start found");
   if (!target) throw std::runtime_error("No target found");
-  return {grid,  start.value(), target.value()};
+  return {std::move(parsed.grid), start.value(), target.value()};
 }
 
-template <typename SearchState>
+// A search state is a cell and a heading, packed into one number so that
+// per-state data can live in flat vectors.
+using search_state_t = uint32_t;
+using visited_t = std::vector<int>;
+constexpr int k_unreached{INT_MAX};
+
+struct Maze {
+  grid::IndexSpace space;
+  // One per cell of the space, the border counts as wall.
+  std::vector<uint8_t> walls;
+
+  explicit Maze(const Grid &grid)
+  : space{grid.bounds()},
+    walls{space.flatten(grid, [](Cell c) -> uint8_t { return c.is_wall(); }, uint8_t{1})} {}
+
+  size_t num_states() const { return space.size() * 4; }
+  search_state_t state(grid::GridIndex cell, Dir2D dir) const { return cell.offset * 4 + dir.idx(); }
+  grid::GridIndex cell(search_state_t state) const { return {state / 4}; }
+  Dir2D dir(search_state_t state) const { return static_cast<Dir2D::Value>(state & 3); }
+  search_state_t state(CoordDir16 s) const { return state(space.index(s.coord()), s.dir()); }
+};
+
 struct PriorityQueue {
-  std::set<std::pair<int, SearchState>> queue{};
-  std::map<SearchState, int> current_cost{};
+  std::set<std::pair<int, search_state_t>> queue{};
+  std::vector<int> current_cost;
+
+  explicit PriorityQueue(size_t num_states) : current_cost(num_states, k_unreached) {}
 
   bool empty() {
     return queue.empty();
   }
 
-  void enqueue(int cost, SearchState search_state) {
-    if (current_cost.contains(search_state)) {
-      int cur_cost{current_cost[search_state]};
+  void enqueue(int cost, search_state_t search_state) {
+    int cur_cost{current_cost[search_state]};
+    if (cur_cost != k_unreached) {
       if (cur_cost <= cost) {
         return;
       }
@@ -81,7 +100,7 @@ struct PriorityQueue {
     current_cost[search_state] = cost;
   }
 
-  std::pair<int, SearchState> dequeue() {
+  std::pair<int, search_state_t> dequeue() {
     assert(!queue.empty());
 
     auto it = queue.begin();
@@ -89,51 +108,46 @@ struct PriorityQueue {
     auto [cost, search_state] = result;
     queue.erase(it);
 
-    assert(current_cost.contains(search_state));
     assert(current_cost[search_state] == cost);
-    current_cost.erase(search_state);
+    current_cost[search_state] = k_unreached;
 
     return result;
   }
 };
 
-using search_state_t = std::pair<Dir2D, Coord2D>;
-using visited_t = std::map<search_state_t, int>;
-
-std::map<search_state_t, int> search(const Grid& grid, Coord2D start, Dir2D start_orientation, Coord2D target) {
-  PriorityQueue<search_state_t> queue{};
-  visited_t visited{};
+visited_t search(const Maze &maze, grid::GridIndex start, Dir2D start_orientation, grid::GridIndex target) {
+  PriorityQueue queue{maze.num_states()};
+  visited_t visited(maze.num_states(), k_unreached);
 
-  search_state_t initial_search_state{start_orientation, start};
-  queue.enqueue(0, initial_search_state);
+  queue.enqueue(0, maze.state(start, start_orientation));
 
   while (!queue.empty()) {
     auto [cur_cost, cur_search_state] = queue.dequeue();
-    auto [cur_dir, cur_coord] = cur_search_state;
+    grid::GridIndex cur_cell{maze.cell(cur_search_state)};
+    Dir2D cur_dir{maze.dir(cur_search_state)};
 
-    assert(!visited.contains(cur_search_state));
+    assert(visited[cur_search_state] == k_unreached);
 
     visited[cur_search_state] = cur_cost;
 
-    std::vector<std::tuple<int, Dir2D, Coord2D>> candidates{
-      {cur_cost + 1000, cur_dir.left(), cur_coord},
-      {cur_cost + 1000, cur_dir.right(), cur_coord},
-      {cur_cost + 1, cur_dir, cur_coord.in_dir(cur_dir)},
-    };
+    const std::array<std::tuple<int, Dir2D, grid::GridIndex>, 3> candidates{{
+      {cur_cost + 1000, cur_dir.left(), cur_cell},
+      {cur_cost + 1000, cur_dir.right(), cur_cell},
+      {cur_cost + 1, cur_dir, maze.space.step(cur_cell, cur_dir)},
+    }};
 
-    if (cur_coord == target) {
-      candidates.pop_back();
-    }
+    // no stepping past the target
+    size_t num_candidates = cur_cell == target ? 2 : 3;
 
-    for (auto cand: candidates) {
-      auto [new_cost, new_dir, new_coord] = cand;
-      search_state_t new_search_state{new_dir, new_coord};
+    for (auto cand: std::span{candidates}.first(num_candidates)) {
+      auto [new_cost, new_dir, new_cell] = cand;
 
-      if (grid[new_coord].is_wall()) {
+      if (maze.walls[new_cell.offset]) {
         continue;
       }
 
-      if (visited.contains(new_search_state)) {
+      search_state_t new_search_state{maze.state(new_cell, new_dir)};
+      if (visited[new_search_state] != k_unreached) {
         continue;
       }
 
@@ -144,14 +158,13 @@ std::map<search_state_t, int> search(const Grid& grid, Coord2D start, Dir2D star
   return visited;
 }
 
-std::optional<int> best_score_at(const visited_t &visited, Coord2D target) {
+std::optional<int> best_score_at(const Maze &maze, const visited_t &visited, grid::GridIndex target) {
   int best_cost{INT_MAX};
   for (auto d: Dir2D::all()) {
-    search_state_t ss{d, target};
-    if (!visited.contains(ss)) {
+    int cost = visited[maze.state(target, d)];
+    if (cost == k_unreached) {
       return {};
     }
-    int cost = visited.at(ss);
     if (cost < best_cost) {
       best_cost = cost;
     }
@@ -159,20 +172,20 @@ std::optional<int> best_score_at(const visited_t &visited, Coord2D target) {
   return best_cost;
 }
 
-std::vector<search_state_t> best_tiles_at(const visited_t &visited, Coord2D target) {
-  std::vector<search_state_t> best_tiles{};
+std::vector<CoordDir16> best_tiles_at(const Maze &maze, const visited_t &visited, grid::GridIndex target) {
+  std::vector<CoordDir16> best_tiles{};
   int best_score{INT_MAX};
   for (auto dir: Dir2D::all()) {
-    search_state_t ss{dir, target};
-    if (!visited.contains(ss)) {
+    int score = visited[maze.state(target, dir)];
+    if (score == k_unreached) {
       continue;
     }
-    int score = visited.at(ss);
+    CoordDir16 tile{maze.space.coord(target), dir};
     if (score < best_score) {
-      best_tiles = {ss};
+      best_tiles = {tile};
       best_score = score;
     } else if ( score == best_score )  {
-      best_tiles.push_back(ss);
+      best_tiles.push_back(tile);
     }
   }
   return best_tiles;
@@ -195,45 +208,50 @@ T pop_back_and_return(Cont &cont) {
 }
 
 
-std::optional<int> all_paths_tiles(const visited_t &visited, Coord2D target) {
-  std::vector<search_state_t> queue = best_tiles_at(visited, target);
-  std::set<Coord2D> tiles{};
+std::optional<int> all_paths_tiles(const Grid &grid, const Maze &maze, const visited_t &visited, grid::GridIndex target) {
+  // Walking back keeps the cell as a coordinate, which is what the tiles
+  // are keyed by; the flat search state is only needed to look up costs.
+  std::vector<CoordDir16> queue = best_tiles_at(maze, visited, target);
+  grid::BitGrid tiles{grid.width(), grid.height()};
   assert(queue.size() > 0);
   while (!queue.empty()) {
-    auto ss{pop_back_and_return(queue)};
-    auto [cur_dir, cur_coord] = ss;
-    auto cur_cost = visited.at(ss);
+    CoordDir16 cur{pop_back_and_return(queue)};
+    Dir2D cur_dir{cur.dir()};
+    auto cur_cost = visited[maze.state(cur)];
 
-    tiles.insert(cur_coord);
+    tiles.set(cur.coord());
 
-    search_state_t stepped_in_from{cur_dir, cur_coord.in_dir(cur_dir.reverse())};
-    search_state_t turned_left_from{cur_dir.right(), cur_coord};
-    search_state_t turned_right_from{cur_dir.left(), cur_coord};
+    CoordDir16 stepped_in_from{cur.coord().in_dir(cur_dir.reverse()), cur_dir};
+    CoordDir16 turned_left_from{cur.with_dir(cur_dir.right())};
+    CoordDir16 turned_right_from{cur.with_dir(cur_dir.left())};
 
-    std::vector<std::pair<search_state_t, int>> candidates{
+    const std::array<std::pair<CoordDir16, int>, 3> candidates{{
       {stepped_in_from, 1},
       {turned_left_from, 1000},
       {turned_right_from, 1000},
-    };
+    }};
     for (auto cand: candidates) {
-      auto [prev_ss, cost_delta] = cand;
-      if (!visited.contains(prev_ss)) {
+      auto [prev, cost_delta] = cand;
+      int prev_cost = visited[maze.state(prev)];
+      if (prev_cost == k_unreached) {
         continue;
       }
-      if (visited.at(prev_ss) != cur_cost - cost_delta) {
+      if (prev_cost != cur_cost - cost_delta) {
         continue;
       }
-      queue.push_back(prev_ss);
+      queue.push_back(prev);
     }
   }
-  return tiles.size();
+  return tiles.count();
 }
 
 int main(int argc, char **argv) {
-  std::vector<std::string> input{read_all_lines()};
-  auto [grid, start, target] = parse_input(input);
-  auto visited = search(grid, start, Dir2D::Right, target);
-
-  handle_optional_result("Best score", best_score_at(visited, target));
-  handle_optional_result("Num tiles in all best paths", all_paths_tiles(visited, target));
+  MappedInput input{MappedInput::from_stdin()};
+  auto [grid, start, target] = parse_input(input.view());
+  Maze maze{grid};
+  grid::GridIndex target_cell{maze.space.index(target)};
+  auto visited = search(maze, maze.space.index(start), Dir2D::Right, target_cell);
+
+  handle_optional_result("Best score", best_score_at(maze, visited, target_cell));
+  handle_optional_result("Num tiles in all best paths", all_paths_tiles(grid, maze, visited, target_cell));
 }
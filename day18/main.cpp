@@ -1,12 +1,19 @@
 #include "lib/lib.hpp"
 #include "lib/coord.h"
+#include "lib/compact_coord.hpp"
+#include "lib/coord_set.hpp"
+#include "lib/mapped_input.hpp"
+#include "lib/parallel_lines.hpp"
+#include "lib/parse.hpp"
+#include "lib/snapshot.hpp"
 #include "lib/color.h"
+#include "lib/stencil.hpp"
 
 #include <chrono>
 #include <map>
 #include <ostream>
-#include <regex>
 #include <set>
+#include <span>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -122,22 +129,37 @@ bool PaddedGrid<Cell, pad_constructor>::is_within_explicit_bounds(Coord2D c) con
 
 using Grid = PaddedGrid<Cell, &Cell::wall>;
 
-std::pair<Grid, std::vector<Coord2D>> parse_input(int width, int height, const std::string& str) {
-  Grid grid{width, height};
-  std::vector<Coord2D> bytes{};
-  std::regex re{"(\\d+),(\\d+)\n", std::regex::multiline};
-  std::sregex_iterator search_begin{str.begin(), str.end(), re}, search_end{};
+// Snapshot sections: the part 1 age, the field size and the falling bytes
+// in the order they fall.
+void parse_input(std::string_view input, snapshot::Builder &out) {
+  parse::Parser parser{input};
+  int p1_target_age = parser.integer<int>();
+  parser.end_of_line();
+  int width = parser.integer<int>();
+  parser.literal(",");
+  int height = parser.integer<int>();
+  parser.end_of_line();
+
+  auto bytes = parse::parse_lines<Coord2D>(parser.rest(), [&](std::string_view text, std::vector<Coord2D> &bytes) {
+    parse::Parser line = parse::Parser::over(input, text);
+    int x = line.integer<int>();
+    line.literal(",");
+    bytes.push_back({x, line.integer<int>()});
+    line.end_of_line();
+  });
+
+  out.add_value(p1_target_age);
+  out.add_value(Coord2D{width, height});
+  out.add(bytes);
+}
 
+Grid build_grid(Coord2D size, std::span<const Coord2D> bytes) {
+  Grid grid{size.x, size.y};
   int age{1};
-  for (auto it = search_begin; it != search_end; ++it, ++age) {
-    Cell content{Cell::falling_byte(age)};
-    std::smatch match{*it};
-    int x = std::stoi(match.str(1));
-    int y = std::stoi(match.str(2));
-    grid.insert({x, y}, content);
-    bytes.push_back({x, y});
+  for (Coord2D c : bytes) {
+    grid.insert(c, Cell::falling_byte(age++));
   }
-  return {std::move(grid), bytes};
+  return grid;
 }
 
 template <class SomeGrid, typename RenderFunctor>
@@ -186,7 +208,8 @@ public:
 namespace pathfind_1 {
   template <typename Obs> struct Search;
 
-  using search_queue_t = std::set<std::pair<int, Coord2D>>;
+  // (steps, cell) entries; compact cells keep each one at 8 bytes.
+  using search_queue_t = std::set<std::pair<int, Coord16>>;
 
   template <class Obs> concept SearchObserverStart   = requires(Obs t) { t.start(int{}, Coord2D{}, Coord2D{}); };
   template <class Obs> concept SearchObserverVisit   = requires(Obs t) { t.visit(Coord2D{}, int{}); };
@@ -270,10 +293,10 @@ namespace pathfind_1 {
     Coord2D m_start, m_target;
     int m_age;
     int m_last_unblocked;
-    using queue_t = std::set<std::pair<int, Coord2D>>;
+    using queue_t = search_queue_t;
 
-    std::map<Coord2D,int> m_best_visit;
-    std::set<std::pair<int, Coord2D>> m_queue;
+    CoordMap<int> m_best_visit;
+    queue_t m_queue;
 
     Search(Grid &grid, Obs &obs = const_cast<Obs&>(null_observer)) : m_grid{grid}, m_obs{obs} {}
     std::optional<int> operator()(int age, Coord2D start, Coord2D target) {
@@ -286,12 +309,13 @@ namespace pathfind_1 {
 
       m_best_visit.clear();
       m_queue.clear();
-      m_queue.insert(std::make_pair(0, m_start));
+      m_queue.emplace(0, Coord16::from(m_start));
 
       std::map<int, queue_t> delayed_queue{};
 
       while (!m_queue.empty()) {
-        auto [steps, coord] = *m_queue.begin();
+        auto [steps, cell] = *m_queue.begin();
+        Coord2D coord = cell;
         if (coord == m_target) {
           return steps;
         }
@@ -299,20 +323,20 @@ namespace pathfind_1 {
         m_best_visit[coord] = steps;
         m_obs.visit(coord, steps);
 
-        for(auto c: {coord.up(), coord.down(), coord.left(), coord.right()}) {
+        stencil::Neighbours4::for_each(coord, [&](Coord2D c) {
           if (m_best_visit.contains(c) && m_best_visit[c] <= steps + 1) {
-            continue;
+            return;
           }
           if (m_grid[c].is_passable(m_age)) {
-            m_queue.emplace(steps + 1, c);
+            m_queue.emplace(steps + 1, Coord16::from(c));
             m_obs.enqueue(c, steps + 1);
-            continue;
+            return;
           }
           if (m_grid[c].is_falling_byte() && m_grid[c].corruption_age() < m_age) {
-            delayed_queue[m_grid[c].corruption_age()].emplace(steps + 1, c);
+            delayed_queue[m_grid[c].corruption_age()].emplace(steps + 1, Coord16::from(c));
             m_obs.delayed(c, steps + 1, m_grid[c].corruption_age());
           }
-        }
+        });
 
         if (m_queue.empty() && !delayed_queue.empty()) {
           auto [oldest_age, blocked_queue] = *(delayed_queue.rbegin());
@@ -428,11 +452,13 @@ template <> class pathfind_1::IsFullObserver<LogObserver>;
 
 
 int main(int argc, char **argv) {
-  int p1_target_age = std::stoi(cin_line());
-  auto [width, height] = parse_n_numbers<int, 2>(cin_line());
-
-  std::string input{read_whole_stdin()};
-  auto [grid, bytes] = parse_input(width, height, input);
+  MappedInput input{MappedInput::from_stdin()};
+  auto snap = snapshot::cached("day18.v1", input.view(), [&](snapshot::Builder &out) {
+    parse_input(input.view(), out);
+  });
+  int p1_target_age = snap.value<int>(0);
+  std::span<const Coord2D> bytes = snap.section<Coord2D>(2);
+  Grid grid{build_grid(snap.value<Coord2D>(1), bytes)};
   int p2_target_age = bytes.size();
 
   std::println("P1 t: {}, P2 t: {}", p1_target_age, p2_target_age);
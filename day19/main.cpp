@@ -1,24 +1,20 @@
 #include "lib/lib.hpp"
+#include "lib/mapped_input.hpp"
+#include "lib/parallel_lines.hpp"
+#include "lib/parse.hpp"
+#include "lib/snapshot.hpp"
+#include "lib/stream_reader.hpp"
 #include <iostream>
 #include <iterator>
+#include <optional>
 #include <print>
 #include <regex>
+#include <span>
+#include <sstream>
 #include <string>
 
 using num_t = int64_t;
-using alternatives_t = std::vector<std::string>;
-
-alternatives_t parse_alternatives(const std::string& str) {
-  alternatives_t result{};
-  std::regex words_re{"\\w+"};
-  auto search_begin = std::sregex_iterator(str.begin(), str.end(), words_re);
-  auto search_end = std::sregex_iterator();
-  for (auto it = search_begin; it != search_end; ++it) {
-    std::smatch match{*it};
-    result.push_back(match.str());
-  }
-  return result;
-}
+using alternatives_t = std::vector<std::string_view>;
 
 num_t count_possibilities(const alternatives_t &alts, std::string_view s) {
   std::vector<num_t> multipliers(s.size() + 1);
@@ -41,25 +37,69 @@ num_t count_possibilities(const alternatives_t &alts, std::string_view s) {
   return multipliers.back();
 }
 
-int main(int argc, char **argv) {
-  std::vector<std::string> input = read_all_lines();
-  assert(input.size() > 2);
+// Snapshot sections: the towel patterns, then the designs, both as strings.
+void parse_input(std::string_view input, snapshot::Builder &out) {
+  parse::Parser parser{input};
+  out.add_strings(parser.list(", ", &parse::Parser::word));
+  parser.end_of_line();
+  parser.literal("\n");
 
-  auto alternatives = parse_alternatives(input[0]);
+  auto designs = parse::parse_lines<std::string_view>(parser.rest(), [&](std::string_view text, std::vector<std::string_view> &designs) {
+    parse::Parser line = parse::Parser::over(input, text);
+    designs.push_back(line.word());
+    line.end_of_line();
+  });
+  out.add_strings(designs);
+}
 
+struct Totals {
   num_t total_alternatives{}, designs_possible{};
 
-
-  for (auto it = input.begin() + 2; it != input.end(); it++) {
-    std::string s{*it};
-    num_t possibilities = count_possibilities(alternatives, s);
+  void add(const alternatives_t &alternatives, std::string_view design) {
+    num_t possibilities = count_possibilities(alternatives, design);
     total_alternatives += possibilities;
     if (possibilities > 0) {
       ++designs_possible;
     }
   }
-  std::println("Possible designs {}", designs_possible);
-  std::println("All options {}", total_alternatives);
+};
+
+// For piped input without snapshots, designs are counted as they're read
+// and only the towel patterns are kept.
+Totals count_streaming() {
+  StreamReader input{StreamReader::from_stdin()};
+  std::optional<std::string_view> first = input.next_line();
+  if (!first) {
+    throw std::runtime_error("Empty input");
+  }
+  parse::Parser parser{*first};
+  std::vector<std::string> patterns{};
+  parser.separated(", ", [&](parse::Parser &p) { patterns.emplace_back(p.word()); });
+  alternatives_t alternatives{patterns.begin(), patterns.end()};
+
+  Totals totals{};
+  input.next_line();
+  input.for_each_line([&](std::string_view design) { totals.add(alternatives, design); });
+  return totals;
+}
+
+int main(int argc, char **argv) {
+  Totals totals{};
+  if (snapshot::enabled() || MappedInput::stdin_is_mappable()) {
+    MappedInput input{MappedInput::from_stdin()};
+    auto snap = snapshot::cached("day19.v1", input.view(), [&](snapshot::Builder &out) {
+      parse_input(input.view(), out);
+    });
+
+    alternatives_t alternatives{snap.strings(0)};
+    for (std::string_view s : snap.strings(2)) {
+      totals.add(alternatives, s);
+    }
+  } else {
+    totals = count_streaming();
+  }
+  std::println("Possible designs {}", totals.designs_possible);
+  std::println("All options {}", totals.total_alternatives);
 }
 
 int main_1(int argc, char **argv) {
@@ -0,0 +1,123 @@
+#include "lib/grid.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares grid::Grid layouts on a BFS over a large random maze, the access
+// pattern of day10/day16/day18 style searches.
+//
+//   grid-layout-bench [size] [wall-percent] [repeats]
+
+struct Cell {
+  enum Value : uint8_t { Empty, Wall } m_val{Empty};
+
+  static Cell out_of_bounds() { return Cell{Wall}; }
+  bool is_wall() const { return m_val == Wall; }
+};
+
+template <class Layout>
+grid::Grid<Cell, Layout> make_maze(int size, int wall_percent, uint32_t seed) {
+  grid::Grid<Cell, Layout> maze{size, size};
+  std::mt19937 rng{seed};
+  std::uniform_int_distribution<int> percent{0, 99};
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      if (percent(rng) < wall_percent) {
+        maze.set({x, y}, Cell{Cell::Wall});
+      }
+    }
+  }
+  maze.set({0, 0}, Cell{});
+  return maze;
+}
+
+// BFS walking by coordinates, every neighbour goes through operator[].
+template <class Layout>
+int64_t bfs_by_coord(const grid::Grid<Cell, Layout> &maze) {
+  grid::Grid<int, Layout> dist{maze.width(), maze.height()};
+  std::vector<Coord2D> frontier{{0, 0}}, next{};
+  int64_t checksum{};
+  int steps{1};
+  dist.set({0, 0}, 1);
+  while (!frontier.empty()) {
+    for (Coord2D c : frontier) {
+      checksum += steps;
+      for (auto dir : Dir2D::all()) {
+        Coord2D n = c.in_dir(dir);
+        // out-of-bounds reads as a wall, so dist is only indexed inside the grid
+        if (maze[n].is_wall() || dist.at_index(dist.index(n)) != 0) {
+          continue;
+        }
+        dist.set(n, steps + 1);
+        next.push_back(n);
+      }
+    }
+    frontier.swap(next);
+    next.clear();
+    ++steps;
+  }
+  return checksum;
+}
+
+// BFS walking by storage index with Layout::step, the bounds check is the
+// only place coordinates are still needed.
+template <class Layout>
+int64_t bfs_by_index(const grid::Grid<Cell, Layout> &maze) {
+  std::vector<int> dist(maze.index({maze.width() - 1, maze.height() - 1}) + 1);
+  std::vector<std::pair<Coord2D, size_t>> frontier{{{0, 0}, maze.index({0, 0})}}, next{};
+  int64_t checksum{};
+  int steps{1};
+  dist[frontier[0].second] = 1;
+  while (!frontier.empty()) {
+    for (auto [c, idx] : frontier) {
+      checksum += steps;
+      for (auto dir : Dir2D::all()) {
+        Coord2D n = c.in_dir(dir);
+        if (!maze.is_within_bounds(n)) {
+          continue;
+        }
+        size_t n_idx = maze.step(idx, dir);
+        if (maze.at_index(n_idx).is_wall() || dist[n_idx] != 0) {
+          continue;
+        }
+        dist[n_idx] = steps + 1;
+        next.emplace_back(n, n_idx);
+      }
+    }
+    frontier.swap(next);
+    next.clear();
+    ++steps;
+  }
+  return checksum;
+}
+
+template <typename Fn>
+void measure(std::string_view name, int repeats, Fn fn) {
+  int64_t checksum{};
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; ++i) {
+    checksum += fn();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  std::println("{:<24} {:>10} us/run  (checksum {})", name, elapsed.count() / repeats, checksum);
+}
+
+int main(int argc, char **argv) {
+  int size = argc > 1 ? std::stoi(argv[1]) : 1000;
+  int wall_percent = argc > 2 ? std::stoi(argv[2]) : 30;
+  int repeats = argc > 3 ? std::stoi(argv[3]) : 5;
+
+  std::println("Maze {}x{}, {}% walls, {} repeats", size, size, wall_percent, repeats);
+
+  auto row_major = make_maze<grid::layout::RowMajor>(size, wall_percent, 42);
+  auto morton = make_maze<grid::layout::Morton>(size, wall_percent, 42);
+
+  measure("row-major, by coord", repeats, [&]() { return bfs_by_coord(row_major); });
+  measure("morton, by coord", repeats, [&]() { return bfs_by_coord(morton); });
+  measure("row-major, by index", repeats, [&]() { return bfs_by_index(row_major); });
+  measure("morton, by index", repeats, [&]() { return bfs_by_index(morton); });
+}
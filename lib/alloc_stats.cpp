@@ -0,0 +1,186 @@
+#include "alloc_stats.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+namespace alloc_stats {
+
+  namespace {
+    // Threads spread their counts over a few copies, to keep pool threads
+    // from fighting over one cache line. Index k_max_names is "no scope".
+    constexpr size_t k_copies = 16;
+    constexpr size_t k_rows = profile::k_max_names + 1;
+
+    struct Row {
+      std::atomic<uint64_t> allocs{0};
+      std::atomic<uint64_t> frees{0};
+      std::atomic<uint64_t> bytes{0};
+    };
+
+    std::array<std::array<Row, k_rows>, k_copies> g_rows{};
+    std::array<std::atomic<int64_t>, k_rows> g_peak_in_scope{};
+    std::atomic<int64_t> g_live{0};
+    std::atomic<int64_t> g_peak{0};
+    std::atomic<size_t> g_next_copy{0};
+    thread_local size_t t_copy = SIZE_MAX;
+
+    Row &row() {
+      if (t_copy == SIZE_MAX) [[unlikely]] {
+        t_copy = g_next_copy.fetch_add(1, std::memory_order_relaxed) % k_copies;
+      }
+      uint32_t scope = profile::t_current_scope;
+      return g_rows[t_copy][scope < profile::k_max_names ? scope : profile::k_max_names];
+    }
+
+    void raise_to(std::atomic<int64_t> &peak, int64_t value) {
+      int64_t seen = peak.load(std::memory_order_relaxed);
+      while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+      }
+    }
+
+    void note_alloc(void *ptr, size_t size) {
+      Row &r = row();
+      r.allocs.fetch_add(1, std::memory_order_relaxed);
+      r.bytes.fetch_add(size, std::memory_order_relaxed);
+      int64_t usable = ::malloc_usable_size(ptr);
+      int64_t live = g_live.fetch_add(usable, std::memory_order_relaxed) + usable;
+      raise_to(g_peak, live);
+      uint32_t scope = profile::t_current_scope;
+      raise_to(g_peak_in_scope[scope < profile::k_max_names ? scope : profile::k_max_names], live);
+    }
+
+    void note_free(void *ptr) {
+      if (!ptr) {
+        return;
+      }
+      row().frees.fetch_add(1, std::memory_order_relaxed);
+      g_live.fetch_sub(::malloc_usable_size(ptr), std::memory_order_relaxed);
+    }
+
+    void *allocate(size_t size, size_t align = 0) {
+      size = std::max<size_t>(size, 1);
+      while (true) {
+        void *ptr = align > alignof(std::max_align_t) ? std::aligned_alloc(align, (size + align - 1) / align * align)
+                                                       : std::malloc(size);
+        if (ptr) {
+          note_alloc(ptr, size);
+          return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+          throw std::bad_alloc{};
+        }
+        handler();
+      }
+    }
+
+    void deallocate(void *ptr) {
+      note_free(ptr);
+      std::free(ptr);
+    }
+
+    std::string mib(int64_t bytes) {
+      return std::format("{:.2f}", bytes / double(1 << 20));
+    }
+
+    void report() {
+      struct Line {
+        size_t row;
+        uint64_t allocs{0};
+        uint64_t frees{0};
+        uint64_t bytes{0};
+      };
+      std::vector<Line> lines{};
+      for (size_t i = 0; i < k_rows; ++i) {
+        Line line{i};
+        for (const auto &copy : g_rows) {
+          line.allocs += copy[i].allocs.load(std::memory_order_relaxed);
+          line.frees += copy[i].frees.load(std::memory_order_relaxed);
+          line.bytes += copy[i].bytes.load(std::memory_order_relaxed);
+        }
+        if (line.allocs > 0 || line.frees > 0) {
+          lines.push_back(line);
+        }
+      }
+      Totals all = totals();
+      std::ranges::sort(lines, std::ranges::greater{}, &Line::allocs);
+
+      std::string text = std::format("\n=== Allocations: {} allocs, {} frees, {} MiB, peak {} MiB live ===\n", all.allocs,
+                                     all.frees, mib(all.bytes), mib(all.peak_live_bytes));
+      text += std::format("{:<32} {:>12} {:>12} {:>12} {:>14}\n", "scope", "allocs", "frees", "MiB", "peak live MiB");
+      for (const Line &line : lines) {
+        std::string name = line.row < profile::k_max_names ? profile::scope_name(line.row) : "(no scope)";
+        text += std::format("{:<32} {:>12} {:>12} {:>12} {:>14}\n", name, line.allocs, line.frees, mib(line.bytes),
+                            mib(g_peak_in_scope[line.row].load(std::memory_order_relaxed)));
+      }
+      std::cerr << text;
+    }
+
+    [[maybe_unused]] const bool k_registered = [] {
+      // Scopes only track t_current_scope once asked to.
+      profile::track_scopes();
+      std::atexit(report);
+      return true;
+    }();
+  }
+
+  Totals totals() {
+    Totals result{};
+    for (const auto &copy : g_rows) {
+      for (const Row &r : copy) {
+        result.allocs += r.allocs.load(std::memory_order_relaxed);
+        result.frees += r.frees.load(std::memory_order_relaxed);
+        result.bytes += r.bytes.load(std::memory_order_relaxed);
+      }
+    }
+    result.live_bytes = g_live.load(std::memory_order_relaxed);
+    result.peak_live_bytes = g_peak.load(std::memory_order_relaxed);
+    return result;
+  }
+
+}
+
+using alloc_stats::allocate;
+using alloc_stats::deallocate;
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void *operator new(size_t size, std::align_val_t align) { return allocate(size, static_cast<size_t>(align)); }
+void *operator new[](size_t size, std::align_val_t align) { return allocate(size, static_cast<size_t>(align)); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { deallocate(ptr); }
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Allocation accounting. Linking //lib:alloc_stats into a binary replaces the
+// global operator new and delete with versions that count allocations, bytes
+// and live bytes, attributed to the innermost TRACE_SCOPE/TRACE_PHASE the
+// allocating thread is in (see profile.hpp), and prints a table of them to
+// stderr at exit. Frees count towards the scope they happen in, which isn't
+// always the one that allocated.
+namespace alloc_stats {
+
+  struct Totals {
+    uint64_t allocs{0};
+    uint64_t frees{0};
+    uint64_t bytes{0};
+    int64_t live_bytes{0};
+    int64_t peak_live_bytes{0};
+  };
+
+  // Across all threads and scopes, so far.
+  Totals totals();
+
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "coord.h"
+#include "grid.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace grid {
+
+  // One bit per cell, every row packed into 64-bit words. Bulk operations work
+  // on whole words, so shifting a frontier or intersecting it with a wall mask
+  // handles 64 cells at a time.
+  class BitGrid {
+  public:
+    using word_t = uint64_t;
+    static constexpr int k_word_bits = 64;
+
+    BitGrid() = default;
+
+    BitGrid(int width, int height)
+    : m_width{width}, m_height{height},
+      m_words_per_row{(width + k_word_bits - 1) / k_word_bits},
+      m_words(static_cast<size_t>(m_words_per_row) * height) {}
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    std::pair<Coord2D, Coord2D> bounds() const { return {{0, 0}, {m_width - 1, m_height - 1}}; }
+
+    bool is_within_bounds(Coord2D c) const {
+      return static_cast<unsigned>(c.x) < static_cast<unsigned>(m_width) &&
+             static_cast<unsigned>(c.y) < static_cast<unsigned>(m_height);
+    }
+
+    bool operator[](Coord2D c) const {
+      if (!is_within_bounds(c)) {
+        return false;
+      }
+      return (word(c) >> (c.x % k_word_bits)) & 1;
+    }
+
+    void set(Coord2D c, bool val = true) {
+      if (!is_within_bounds(c)) {
+        throw std::runtime_error("Can't grow");
+      }
+      word_t bit = word_t{1} << (c.x % k_word_bits);
+      if (val) {
+        word(c) |= bit;
+      } else {
+        word(c) &= ~bit;
+      }
+    }
+
+    void reset(Coord2D c) { set(c, false); }
+
+    void clear() { std::ranges::fill(m_words, 0); }
+
+    // Number of set cells.
+    size_t count() const {
+      size_t result{};
+      for (word_t w : m_words) {
+        result += std::popcount(w);
+      }
+      return result;
+    }
+
+    bool any() const {
+      return std::ranges::any_of(m_words, [](word_t w) { return w != 0; });
+    }
+
+    BitGrid &operator&=(const BitGrid &other) {
+      check_same_shape(other);
+      for (size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] &= other.m_words[i];
+      }
+      return *this;
+    }
+
+    BitGrid &operator|=(const BitGrid &other) {
+      check_same_shape(other);
+      for (size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] |= other.m_words[i];
+      }
+      return *this;
+    }
+
+    BitGrid &operator^=(const BitGrid &other) {
+      check_same_shape(other);
+      for (size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] ^= other.m_words[i];
+      }
+      return *this;
+    }
+
+    // this &= ~other
+    BitGrid &andnot(const BitGrid &other) {
+      check_same_shape(other);
+      for (size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] &= ~other.m_words[i];
+      }
+      return *this;
+    }
+
+    friend BitGrid operator&(BitGrid a, const BitGrid &b) { return a &= b; }
+    friend BitGrid operator|(BitGrid a, const BitGrid &b) { return a |= b; }
+    friend BitGrid operator^(BitGrid a, const BitGrid &b) { return a ^= b; }
+
+    bool operator==(const BitGrid &other) const = default;
+
+    // Move every set cell one step in `dir`, cells pushed over the edge are dropped.
+    BitGrid &shift(Dir2D dir) {
+      switch (dir.m_val) {
+      case Dir2D::Up: shift_rows(-1); break;
+      case Dir2D::Down: shift_rows(1); break;
+      case Dir2D::Left: shift_left(); break;
+      case Dir2D::Right: shift_right(); break;
+      }
+      return *this;
+    }
+
+    BitGrid shifted(Dir2D dir) const {
+      BitGrid result{*this};
+      result.shift(dir);
+      return result;
+    }
+
+    // Union of the four single-step shifts, i.e. the 4-neighbourhood of every set cell.
+    BitGrid neighbours() const {
+      BitGrid result{shifted(Dir2D::Up)};
+      for (auto dir : {Dir2D::Right, Dir2D::Down, Dir2D::Left}) {
+        result |= shifted(dir);
+      }
+      return result;
+    }
+
+    template <typename Fn>
+    void for_each_set(Fn fn) const {
+      for (int y = 0; y < m_height; ++y) {
+        const word_t *row = row_words(y);
+        for (int w = 0; w < m_words_per_row; ++w) {
+          word_t bits = row[w];
+          while (bits) {
+            int x = w * k_word_bits + std::countr_zero(bits);
+            fn(Coord2D{x, y});
+            bits &= bits - 1;
+          }
+        }
+      }
+    }
+
+    template <class Cell, class Layout, typename Pred>
+    static BitGrid from_grid(const Grid<Cell, Layout> &grid, Pred pred) {
+      auto [top_left, bottom_right] = grid.bounds();
+      BitGrid result{grid.width(), grid.height()};
+      for (int y = 0; y < result.m_height; ++y) {
+        for (int x = 0; x < result.m_width; ++x) {
+          if (pred(grid[top_left + Coord2D{x, y}])) {
+            result.word({x, y}) |= word_t{1} << (x % k_word_bits);
+          }
+        }
+      }
+      return result;
+    }
+
+    template <class Cell>
+    Grid<Cell> to_grid(Cell set_value, Cell clear_value = Cell{}) const {
+      Grid<Cell> result{m_width, m_height};
+      for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+          result.set({x, y}, (*this)[{x, y}] ? set_value : clear_value);
+        }
+      }
+      return result;
+    }
+
+    const word_t *row_words(int y) const { return m_words.data() + static_cast<size_t>(y) * m_words_per_row; }
+    word_t *row_words(int y) { return m_words.data() + static_cast<size_t>(y) * m_words_per_row; }
+    int words_per_row() const { return m_words_per_row; }
+
+  private:
+    word_t &word(Coord2D c) { return row_words(c.y)[c.x / k_word_bits]; }
+    word_t word(Coord2D c) const { return row_words(c.y)[c.x / k_word_bits]; }
+
+    // Bits past m_width in the last word of each row must stay clear, otherwise
+    // count() and shifts would see phantom cells.
+    word_t tail_mask() const {
+      int used = m_width % k_word_bits;
+      return used ? (word_t{1} << used) - 1 : ~word_t{0};
+    }
+
+    void check_same_shape(const BitGrid &other) const {
+      if (m_width != other.m_width || m_height != other.m_height) {
+        throw std::runtime_error("BitGrid shape mismatch");
+      }
+    }
+
+    void shift_rows(int dy) {
+      if (m_height == 0) {
+        return;
+      }
+      size_t stride = m_words_per_row;
+      if (dy < 0) {
+        std::copy(m_words.begin() + stride, m_words.end(), m_words.begin());
+        std::fill(m_words.end() - stride, m_words.end(), 0);
+      } else {
+        std::copy_backward(m_words.begin(), m_words.end() - stride, m_words.end());
+        std::fill(m_words.begin(), m_words.begin() + stride, 0);
+      }
+    }
+
+    void shift_right() {
+      if (m_words_per_row == 0) {
+        return;
+      }
+      word_t mask = tail_mask();
+      for (int y = 0; y < m_height; ++y) {
+        word_t *row = row_words(y);
+        for (int w = m_words_per_row - 1; w >= 0; --w) {
+          row[w] = (row[w] << 1) | (w > 0 ? row[w - 1] >> (k_word_bits - 1) : 0);
+        }
+        row[m_words_per_row - 1] &= mask;
+      }
+    }
+
+    void shift_left() {
+      for (int y = 0; y < m_height; ++y) {
+        word_t *row = row_words(y);
+        for (int w = 0; w < m_words_per_row; ++w) {
+          row[w] = (row[w] >> 1) | (w + 1 < m_words_per_row ? row[w + 1] << (k_word_bits - 1) : 0);
+        }
+      }
+    }
+
+    int m_width{0};
+    int m_height{0};
+    int m_words_per_row{0};
+    std::vector<word_t> m_words{};
+  };
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "coord.h"
+
+#include <compare>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+// Coordinates with a narrower component type, for search states that are
+// stored by the million. They convert losslessly to Coord2D; coming from a
+// Coord2D the value is range checked, since no puzzle grid needs it but a
+// silent wrap would be a miserable bug to find.
+template <class T>
+struct BasicCoord2D {
+  T x = 0;
+  T y = 0;
+
+  static constexpr BasicCoord2D from(Coord2D c) {
+    if (!fits(c.x) || !fits(c.y)) {
+      throw std::out_of_range(std::format("{} doesn't fit in a compact coordinate", c));
+    }
+    return {static_cast<T>(c.x), static_cast<T>(c.y)};
+  }
+
+  constexpr operator Coord2D() const { return {x, y}; }
+
+  // Same order as Coord2D: by x, then by y.
+  constexpr auto operator<=>(const BasicCoord2D &) const = default;
+
+  constexpr BasicCoord2D in_dir(Dir2D dir) const {
+    return {static_cast<T>(x + dir.dx()), static_cast<T>(y + dir.dy())};
+  }
+
+private:
+  static constexpr bool fits(int v) {
+    return v >= std::numeric_limits<T>::min() && v <= std::numeric_limits<T>::max();
+  }
+};
+
+using Coord16 = BasicCoord2D<int16_t>;
+static_assert(sizeof(Coord16) == 4);
+
+// A cell and a heading in one 32-bit word: two bits of direction and 15 bits
+// per coordinate, so coordinates must lie in [-16384, 16383]. Compared as the
+// word, which is as good as any order for sets and maps.
+class CoordDir16 {
+public:
+  static constexpr int k_min = -(1 << 14);
+  static constexpr int k_max = (1 << 14) - 1;
+
+  constexpr CoordDir16() = default;
+  constexpr CoordDir16(Coord2D c, Dir2D dir) {
+    if (c.x < k_min || c.x > k_max || c.y < k_min || c.y > k_max) {
+      throw std::out_of_range(std::format("{} doesn't fit in a CoordDir16", c));
+    }
+    m_word = (field(c.x) << 17) | (field(c.y) << 2) | static_cast<uint32_t>(dir.idx());
+  }
+
+  constexpr Coord2D coord() const { return {unfield(m_word >> 17), unfield(m_word >> 2)}; }
+  constexpr Dir2D dir() const { return static_cast<Dir2D::Value>(m_word & 3); }
+  constexpr uint32_t word() const { return m_word; }
+
+  constexpr CoordDir16 with_dir(Dir2D dir) const { return from_word((m_word & ~uint32_t{3}) | dir.idx()); }
+  constexpr CoordDir16 forward() const { return {coord().in_dir(dir()), dir()}; }
+
+  static constexpr CoordDir16 from_word(uint32_t word) {
+    CoordDir16 result{};
+    result.m_word = word;
+    return result;
+  }
+
+  constexpr auto operator<=>(const CoordDir16 &) const = default;
+
+private:
+  static constexpr uint32_t k_field_mask = (1u << 15) - 1;
+
+  static constexpr uint32_t field(int v) { return static_cast<uint32_t>(v) & k_field_mask; }
+  // Sign-extends the low 15 bits.
+  static constexpr int unfield(uint32_t bits) {
+    return static_cast<int>((bits & k_field_mask) ^ (1u << 14)) - (1 << 14);
+  }
+
+  uint32_t m_word{0};
+};
+static_assert(sizeof(CoordDir16) == 4);
+
+template <class T>
+struct std::hash<BasicCoord2D<T>> {
+  size_t operator()(const BasicCoord2D<T> &c) const noexcept { return std::hash<Coord2D>{}(c); }
+};
+
+template <>
+struct std::hash<CoordDir16> {
+  size_t operator()(const CoordDir16 &s) const noexcept {
+    return std::hash<Coord2D>{}(Coord2D::from_packed(s.word()));
+  }
+};
+
+template <class T>
+struct std::formatter<BasicCoord2D<T>, char> : std::formatter<Coord2D, char> {
+  template <class FmtContext>
+  FmtContext::iterator format(const BasicCoord2D<T> &coord, FmtContext &ctx) const {
+    return std::formatter<Coord2D, char>::format(coord, ctx);
+  }
+};
@@ -2,7 +2,9 @@
 #include <algorithm>
 #include <cstdint>
 #include <format>
+#include <functional>
 #include <sstream>
+#include <string>
 #include <array>
 
 struct Dir2D {
@@ -20,56 +22,35 @@ struct Dir2D {
   // Dir2D &operator=(const Dir2D &o) { m_val = o.m_val; return *this; }
   // Dir2D &operator=(Dir2D &&o) { m_val = o.m_val; return *this; }
 
-  Dir2D(Value val) : m_val(val) {};
+  constexpr Dir2D(Value val) : m_val(val) {};
 
   static constexpr std::array<Dir2D, 4> all();
 
-  int idx() const {
-    switch (m_val) {
-    case Up: return 0;
-    case Right: return 1;
-    case Down: return 2;
-    case Left: return 3;
-    }
-  }
+  // Directions are numbered clockwise, so turning is modular arithmetic and
+  // per-direction data is a table lookup instead of a switch.
+  static constexpr std::array<int, 4> k_dx{0, 1, 0, -1};
+  static constexpr std::array<int, 4> k_dy{-1, 0, 1, 0};
 
-  bool operator==(Value val) const { return m_val == val; }
-  operator int() const { return static_cast<int>(m_val); }
+  constexpr int idx() const { return m_val; }
 
-  Dir2D reverse() const {
-    switch (m_val) {
-    case Up: return Down;
-    case Right: return Left;
-    case Down: return Up;
-    case Left: return Right;
-    }
-  }
+  constexpr bool operator==(Value val) const { return m_val == val; }
+  constexpr operator int() const { return static_cast<int>(m_val); }
 
-  Dir2D left() const {
-    switch (m_val) {
-    case Up: return Left;
-    case Right: return Up;
-    case Down: return Right;
-    case Left: return Down;
-    }
-  }
+  constexpr Dir2D reverse() const { return rotated(2); }
+  constexpr Dir2D left() const { return rotated(3); }
+  constexpr Dir2D right() const { return rotated(1); }
 
-  Dir2D right() const {
-    switch (m_val) {
-    case Up: return Right;
-    case Right: return Down;
-    case Down: return Left;
-    case Left: return Up;
-    }
-  }
+  constexpr int dx() const { return k_dx[m_val]; }
+  constexpr int dy() const { return k_dy[m_val]; }
 
   std::string str() const {
-    switch (m_val) {
-    case Up: return "↑";
-    case Right: return "→";
-    case Down: return "↓";
-    case Left: return "←";
-    }
+    static constexpr std::array<const char *, 4> k_arrows{"↑", "→", "↓", "←"};
+    return k_arrows[m_val];
+  }
+
+private:
+  constexpr Dir2D rotated(int quarter_turns) const {
+    return static_cast<Value>((m_val + quarter_turns) & 3);
   }
 };
 
@@ -79,13 +60,7 @@ inline constexpr std::array<Dir2D, 4> Dir2D::all() {
 
 
 inline std::ostream& operator<<(std::ostream& os, Dir2D dir) {
-  switch (dir.m_val) {
-  case Dir2D::Up: os << "↑"; break;
-  case Dir2D::Right: os << "→"; break;
-  case Dir2D::Down: os << "↓"; break;
-  case Dir2D::Left: os << "←"; break;
-  }
-  return os;
+  return os << dir.str();
 }
 
 
@@ -121,13 +96,8 @@ struct Coord2D {
     y = tmp.y;
   }
 
-  inline Coord2D in_dir(Dir2D dir) const {
-    switch (dir.m_val) {
-    case Dir2D::Up: return {x, y - 1};
-    case Dir2D::Right: return {x + 1, y};
-    case Dir2D::Down: return {x, y + 1};
-    case Dir2D::Left: return {x - 1, y};
-    }
+  inline constexpr Coord2D in_dir(Dir2D dir) const {
+    return {x + dir.dx(), y + dir.dy()};
   }
 
   inline Coord2D up() const {
@@ -156,6 +126,28 @@ struct Coord2D {
     x = std::max(x, coord.x);
     y = std::max(y, coord.y);
   }
+
+  // Both coordinates in one 64-bit word, x in the high half.
+  constexpr uint64_t packed() const {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+  }
+  static constexpr Coord2D from_packed(uint64_t key) {
+    return {static_cast<int>(static_cast<uint32_t>(key >> 32)), static_cast<int>(static_cast<uint32_t>(key))};
+  }
+};
+
+template<>
+struct std::hash<Coord2D> {
+  size_t operator()(const Coord2D &c) const noexcept {
+    // murmur3's finalizer; neighbouring coords land far apart.
+    uint64_t h = c.packed();
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
 };
 
 
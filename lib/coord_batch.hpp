@@ -0,0 +1,217 @@
+#pragma once
+
+#include "bitgrid.hpp"
+#include "coord.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace coord_batch_detail {
+
+  // Keeps the lane arrays 32-byte aligned for AVX2 loads and stores.
+  template <class T>
+  struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t k_align{32};
+
+    AlignedAllocator() = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), k_align)); }
+    void deallocate(T *p, size_t) { ::operator delete(p, k_align); }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U> &) const { return true; }
+  };
+
+}
+
+// Many coordinates stored structure-of-arrays: all xs in one array, all ys in
+// another. Whole-batch arithmetic runs 8 lanes at a time with AVX2 when the
+// target has it, and in a scalar loop otherwise (and for the tail).
+//
+// Per-agent masks are bit vectors, bit i of word i / 64 for agent i.
+class CoordBatch {
+public:
+  using lanes_t = std::vector<int32_t, coord_batch_detail::AlignedAllocator<int32_t>>;
+  using mask_t = std::vector<uint64_t>;
+
+  CoordBatch() = default;
+  explicit CoordBatch(size_t size) : m_xs(size), m_ys(size) {}
+
+  template <class Range>
+  static CoordBatch from(const Range &coords) {
+    CoordBatch result{};
+    for (Coord2D c : coords) {
+      result.push_back(c);
+    }
+    return result;
+  }
+
+  void push_back(Coord2D c) {
+    m_xs.push_back(c.x);
+    m_ys.push_back(c.y);
+  }
+
+  size_t size() const { return m_xs.size(); }
+  bool empty() const { return m_xs.empty(); }
+  Coord2D operator[](size_t i) const { return {m_xs[i], m_ys[i]}; }
+
+  std::span<int32_t> xs() { return m_xs; }
+  std::span<int32_t> ys() { return m_ys; }
+  std::span<const int32_t> xs() const { return m_xs; }
+  std::span<const int32_t> ys() const { return m_ys; }
+
+  // this[i] += other[i]
+  CoordBatch &add(const CoordBatch &other) {
+    check_same_size(other);
+    add_lanes(m_xs.data(), other.m_xs.data(), size());
+    add_lanes(m_ys.data(), other.m_ys.data(), size());
+    return *this;
+  }
+
+  // this[i] *= k, both coordinates.
+  CoordBatch &mul_scalar(int32_t k) {
+    mul_lanes(m_xs.data(), k, size());
+    mul_lanes(m_ys.data(), k, size());
+    return *this;
+  }
+
+  // Wraps every coordinate into [0, bounds.x) x [0, bounds.y), negative ones
+  // included; the bounds must be positive.
+  CoordBatch &wrap_mod(Coord2D bounds) {
+    if (bounds.x <= 0 || bounds.y <= 0) {
+      throw std::invalid_argument("wrap_mod needs positive bounds");
+    }
+    wrap_lanes(m_xs.data(), bounds.x, size());
+    wrap_lanes(m_ys.data(), bounds.y, size());
+    return *this;
+  }
+
+  // Bit i is set when this[i] lies inside the rectangle, corners included.
+  mask_t within_bounds(Coord2D top_left, Coord2D bottom_right) const {
+    mask_t result((size() + 63) / 64);
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i lo_x = _mm256_set1_epi32(top_left.x - 1), hi_x = _mm256_set1_epi32(bottom_right.x + 1);
+    const __m256i lo_y = _mm256_set1_epi32(top_left.y - 1), hi_y = _mm256_set1_epi32(bottom_right.y + 1);
+    for (; i + 8 <= size(); i += 8) {
+      __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i *>(m_xs.data() + i));
+      __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i *>(m_ys.data() + i));
+      __m256i in = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(x, lo_x), _mm256_cmpgt_epi32(hi_x, x)),
+                                    _mm256_and_si256(_mm256_cmpgt_epi32(y, lo_y), _mm256_cmpgt_epi32(hi_y, y)));
+      uint64_t bits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(in)));
+      result[i / 64] |= bits << (i % 64);
+    }
+#endif
+    for (; i < size(); ++i) {
+      if ((*this)[i].within_bounds(top_left, bottom_right)) {
+        result[i / 64] |= uint64_t{1} << (i % 64);
+      }
+    }
+    return result;
+  }
+
+  // Sets the cell of every coordinate in `grid` (only the masked ones, when a
+  // mask is given). Returns how many of them landed on an already set cell.
+  // Scattered writes don't vectorize on AVX2, so this is a plain loop.
+  size_t scatter(grid::BitGrid &grid) const {
+    size_t collisions{};
+    for (size_t i = 0; i < size(); ++i) {
+      collisions += scatter_one(grid, (*this)[i]);
+    }
+    return collisions;
+  }
+
+  size_t scatter(grid::BitGrid &grid, const mask_t &mask) const {
+    size_t collisions{};
+    for (size_t w = 0; w < mask.size(); ++w) {
+      for (uint64_t bits = mask[w]; bits; bits &= bits - 1) {
+        collisions += scatter_one(grid, (*this)[w * 64 + std::countr_zero(bits)]);
+      }
+    }
+    return collisions;
+  }
+
+private:
+  static bool scatter_one(grid::BitGrid &grid, Coord2D c) {
+    bool was_set = grid[c];
+    grid.set(c);
+    return was_set;
+  }
+
+  void check_same_size(const CoordBatch &other) const {
+    if (other.size() != size()) {
+      throw std::invalid_argument("CoordBatch sizes differ");
+    }
+  }
+
+  static void add_lanes(int32_t *a, const int32_t *b, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+      __m256i va = _mm256_load_si256(reinterpret_cast<const __m256i *>(a + i));
+      __m256i vb = _mm256_load_si256(reinterpret_cast<const __m256i *>(b + i));
+      _mm256_store_si256(reinterpret_cast<__m256i *>(a + i), _mm256_add_epi32(va, vb));
+    }
+#endif
+    for (; i < n; ++i) {
+      a[i] += b[i];
+    }
+  }
+
+  static void mul_lanes(int32_t *a, int32_t k, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i vk = _mm256_set1_epi32(k);
+    for (; i + 8 <= n; i += 8) {
+      __m256i va = _mm256_load_si256(reinterpret_cast<const __m256i *>(a + i));
+      _mm256_store_si256(reinterpret_cast<__m256i *>(a + i), _mm256_mullo_epi32(va, vk));
+    }
+#endif
+    for (; i < n; ++i) {
+      a[i] *= k;
+    }
+  }
+
+  // There's no vector integer division, so the quotient comes from a double
+  // multiply by 1/m; it can be off by one, which the two compares fix up.
+  static void wrap_lanes(int32_t *a, int32_t m, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256d inv = _mm256_set1_pd(1.0 / m);
+    const __m256i vm = _mm256_set1_epi32(m);
+    const __m256i vm_minus_1 = _mm256_set1_epi32(m - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+      __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(a + i));
+      __m128i q_lo = _mm256_cvttpd_epi32(_mm256_floor_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), inv)));
+      __m128i q_hi = _mm256_cvttpd_epi32(_mm256_floor_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), inv)));
+      __m256i q = _mm256_set_m128i(q_hi, q_lo);
+      __m256i r = _mm256_sub_epi32(v, _mm256_mullo_epi32(q, vm));
+      r = _mm256_add_epi32(r, _mm256_and_si256(_mm256_cmpgt_epi32(zero, r), vm));
+      r = _mm256_sub_epi32(r, _mm256_and_si256(_mm256_cmpgt_epi32(r, vm_minus_1), vm));
+      _mm256_store_si256(reinterpret_cast<__m256i *>(a + i), r);
+    }
+#endif
+    for (; i < n; ++i) {
+      a[i] %= m;
+      if (a[i] < 0) {
+        a[i] += m;
+      }
+    }
+  }
+
+  lanes_t m_xs{};
+  lanes_t m_ys{};
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "coord.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Flat open-addressing replacements for std::set<Coord2D> and
+// std::map<Coord2D, T>. Keys are Coord2D::packed() words in a single array,
+// probed linearly from std::hash<Coord2D>, so inserts don't allocate nodes and
+// lookups touch one or two cache lines. clear() keeps the storage for reuse.
+//
+// Iteration order is unspecified (it follows the hash), and any insert or
+// erase invalidates iterators and value pointers. Coord2D{INT_MIN, INT_MIN}
+// marks empty slots and can't be stored.
+namespace coord_table_detail {
+
+  struct NoValue {};
+
+  template <class Value>
+  class FlatTable {
+  public:
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_keys.size(); }
+
+    void clear() {
+      if (m_size != 0) {
+        std::fill(m_keys.begin(), m_keys.end(), k_empty);
+        m_size = 0;
+      }
+    }
+
+    // Makes room for `n` entries without further rehashing.
+    void reserve(size_t n) {
+      if (n * 2 > m_keys.size()) {
+        rehash(n * 2);
+      }
+    }
+
+    bool contains(Coord2D c) const {
+      return m_size != 0 && m_keys[probe(c.packed())] == c.packed();
+    }
+
+    bool erase(Coord2D c) {
+      if (m_size == 0) {
+        return false;
+      }
+      size_t hole = probe(c.packed());
+      if (m_keys[hole] != c.packed()) {
+        return false;
+      }
+      // Backward-shift deletion: pull later entries of the same probe run
+      // into the hole so lookups never need tombstones.
+      size_t mask = m_keys.size() - 1;
+      for (size_t next = (hole + 1) & mask; m_keys[next] != k_empty; next = (next + 1) & mask) {
+        size_t home = home_slot(m_keys[next]);
+        bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+          m_keys[hole] = m_keys[next];
+          if constexpr (k_has_values) {
+            m_values[hole] = std::move(m_values[next]);
+          }
+          hole = next;
+        }
+      }
+      m_keys[hole] = k_empty;
+      --m_size;
+      return true;
+    }
+
+  protected:
+    static constexpr bool k_has_values = !std::is_same_v<Value, NoValue>;
+    static constexpr uint64_t k_empty = Coord2D{INT_MIN, INT_MIN}.packed();
+    static constexpr size_t k_min_capacity = 16;
+
+    size_t home_slot(uint64_t key) const {
+      return std::hash<Coord2D>{}(Coord2D::from_packed(key)) & (m_keys.size() - 1);
+    }
+
+    // The slot holding `key`, or the empty slot where it would go.
+    size_t probe(uint64_t key) const {
+      size_t mask = m_keys.size() - 1;
+      size_t i = home_slot(key);
+      while (m_keys[i] != key && m_keys[i] != k_empty) {
+        i = (i + 1) & mask;
+      }
+      return i;
+    }
+
+    // Finds or inserts `c`; new entries get a value-initialized Value.
+    std::pair<size_t, bool> insert_slot(Coord2D c) {
+      uint64_t key = c.packed();
+      if (key == k_empty) [[unlikely]] {
+        throw std::invalid_argument(std::format("{} is reserved and can't be stored", c));
+      }
+      // Kept at most half full, probe runs stay short.
+      if ((m_size + 1) * 2 > m_keys.size()) {
+        rehash(std::max(m_keys.size() * 2, k_min_capacity));
+      }
+      size_t i = probe(key);
+      if (m_keys[i] == key) {
+        return {i, false};
+      }
+      m_keys[i] = key;
+      if constexpr (k_has_values) {
+        m_values[i] = Value{};
+      }
+      ++m_size;
+      return {i, true};
+    }
+
+    void rehash(size_t min_capacity) {
+      size_t capacity = k_min_capacity;
+      while (capacity < min_capacity) {
+        capacity *= 2;
+      }
+      std::vector<uint64_t> old_keys(capacity, k_empty);
+      std::swap(old_keys, m_keys);
+      std::vector<Value> old_values{};
+      if constexpr (k_has_values) {
+        old_values.resize(capacity);
+        std::swap(old_values, m_values);
+      }
+      for (size_t i = 0; i < old_keys.size(); ++i) {
+        if (old_keys[i] != k_empty) {
+          size_t slot = probe(old_keys[i]);
+          m_keys[slot] = old_keys[i];
+          if constexpr (k_has_values) {
+            m_values[slot] = std::move(old_values[i]);
+          }
+        }
+      }
+    }
+
+    // Slot iteration shared by both containers; Deref turns a slot into
+    // whatever the iterator yields.
+    template <class Table, class Deref>
+    class SlotIterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using difference_type = std::ptrdiff_t;
+      using value_type = std::remove_cvref_t<decltype(Deref{}(std::declval<Table &>(), size_t{}))>;
+
+      SlotIterator() = default;
+      SlotIterator(Table *table, size_t slot) : m_table{table}, m_slot{slot} { skip_empty(); }
+
+      decltype(auto) operator*() const { return Deref{}(*m_table, m_slot); }
+      SlotIterator &operator++() { ++m_slot; skip_empty(); return *this; }
+      SlotIterator operator++(int) { SlotIterator prev{*this}; ++*this; return prev; }
+      bool operator==(const SlotIterator &other) const { return m_slot == other.m_slot; }
+
+    private:
+      void skip_empty() {
+        const auto &keys = static_cast<const FlatTable &>(*m_table).m_keys;
+        while (m_slot < keys.size() && keys[m_slot] == k_empty) {
+          ++m_slot;
+        }
+      }
+
+      Table *m_table{nullptr};
+      size_t m_slot{0};
+    };
+
+    std::vector<uint64_t> m_keys{};
+    std::vector<Value> m_values{};
+    size_t m_size{0};
+  };
+
+}
+
+class CoordSet : public coord_table_detail::FlatTable<coord_table_detail::NoValue> {
+  struct Deref {
+    Coord2D operator()(const CoordSet &set, size_t slot) const { return Coord2D::from_packed(set.m_keys[slot]); }
+  };
+
+public:
+  using value_type = Coord2D;
+  using iterator = SlotIterator<const CoordSet, Deref>;
+  using const_iterator = iterator;
+
+  CoordSet() = default;
+  CoordSet(std::initializer_list<Coord2D> coords) {
+    for (Coord2D c : coords) {
+      insert(c);
+    }
+  }
+
+  // True when `c` wasn't there before.
+  bool insert(Coord2D c) { return insert_slot(c).second; }
+
+  iterator begin() const { return {this, 0}; }
+  iterator end() const { return {this, m_keys.size()}; }
+};
+
+template <class T>
+class CoordMap : public coord_table_detail::FlatTable<T> {
+  using base = coord_table_detail::FlatTable<T>;
+  using base::m_keys;
+  using base::m_values;
+
+  template <class Map, class Ref>
+  struct Deref {
+    std::pair<Coord2D, Ref> operator()(Map &map, size_t slot) const {
+      return {Coord2D::from_packed(map.m_keys[slot]), map.m_values[slot]};
+    }
+  };
+
+public:
+  using mapped_type = T;
+  using iterator = typename base::template SlotIterator<CoordMap, Deref<CoordMap, T &>>;
+  using const_iterator = typename base::template SlotIterator<const CoordMap, Deref<const CoordMap, const T &>>;
+
+  T &operator[](Coord2D c) { return m_values[this->insert_slot(c).first]; }
+
+  // Pointer to the value stored for `c`, or nullptr.
+  T *find(Coord2D c) {
+    return const_cast<T *>(std::as_const(*this).find(c));
+  }
+  const T *find(Coord2D c) const {
+    if (this->m_size == 0) {
+      return nullptr;
+    }
+    size_t slot = this->probe(c.packed());
+    return m_keys[slot] == c.packed() ? &m_values[slot] : nullptr;
+  }
+
+  const T &at(Coord2D c) const {
+    if (const T *val = find(c)) {
+      return *val;
+    }
+    throw std::out_of_range(std::format("No value at {}", c));
+  }
+  T &at(Coord2D c) { return const_cast<T &>(std::as_const(*this).at(c)); }
+
+  // True when `c` wasn't there before.
+  bool insert_or_assign(Coord2D c, T val) {
+    auto [slot, inserted] = this->insert_slot(c);
+    m_values[slot] = std::move(val);
+    return inserted;
+  }
+
+  iterator begin() { return {this, 0}; }
+  iterator end() { return {this, m_keys.size()}; }
+  const_iterator begin() const { return {this, 0}; }
+  const_iterator end() const { return {this, m_keys.size()}; }
+};
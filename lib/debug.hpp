@@ -1,6 +1,13 @@
 #pragma once
 
-#define DEBUG_BIT(NAME, BIT) [[maybe_unused]] constexpr uint32_t NAME{1 << BIT};
+#include "trace.hpp"
+
+// A DEBUG_BIT is both a compile-time switch (SETUP_DEBUG) that prints its
+// DPRINTs as they happen, and a trace category that can be turned on at
+// runtime (see trace.hpp) to record them instead.
+#define DEBUG_BIT(NAME, BIT)                                                                                   \
+  [[maybe_unused]] constexpr uint32_t NAME{1 << BIT};                                                          \
+  [[maybe_unused]] static const uint32_t NAME##_TRACE = ::trace::define_category(#NAME, NAME);
 
 #define SETUP_DEBUG(val)                                                                                       \
   constexpr uint32_t DEBUG = val;                                                                              \
@@ -27,5 +34,18 @@
 
 
 
-#define DPRINT(flags, ...) println_if<flags>("{} \033[90m({}():{})\033[00m",  std::format(__VA_ARGS__), __FUNCTION__, __LINE__)
-#define DDUMP(flags, ...) println_if<flags>("{} = {} \033[90m({}():{})\033[00m", #__VA_ARGS__, (__VA_ARGS__), __FUNCTION__, __LINE__)
+#define DPRINT(flags, ...)                                                                                     \
+  do {                                                                                                         \
+    if constexpr (DEBUG & (flags)) {                                                                           \
+      println_if<flags>("{} \033[90m({}():{})\033[00m",  std::format(__VA_ARGS__), __FUNCTION__, __LINE__);     \
+    }                                                                                                          \
+    TRACE_EVENT(flags, __VA_ARGS__);                                                                           \
+  } while (0)
+
+#define DDUMP(flags, ...)                                                                                      \
+  do {                                                                                                         \
+    if constexpr (DEBUG & (flags)) {                                                                           \
+      println_if<flags>("{} = {} \033[90m({}():{})\033[00m", #__VA_ARGS__, (__VA_ARGS__), __FUNCTION__, __LINE__); \
+    }                                                                                                          \
+    TRACE_EVENT(flags, "{} = {}", #__VA_ARGS__, (__VA_ARGS__));                                                \
+  } while (0)
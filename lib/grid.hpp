@@ -1,33 +1,57 @@
 #pragma once
 
 #include "coord.h"
+#include "grid_layout.hpp"
 
-#include <map>
+#include <span>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 namespace grid {
 
-  template <class Cell>
+  // Dense storage: every cell inside the bounds is materialized, so lookups
+  // are a bounds check plus an index computation. Layout decides how cells are
+  // ordered in memory (see grid_layout.hpp); row-major unless asked otherwise.
+  template <class Cell, class Layout = layout::RowMajor>
   class Grid {
   public:
     using value_t = Cell;
-
-    Grid(Grid &&other)
-    : m_top_left{other.m_top_left},
-      m_bottom_right{other.m_bottom_right},
-      m_map{std::move(other.m_map)}
+    using layout_t = Layout;
+
+    // A moved-from grid is empty, bounds included, so it can't index into
+    // the cells it gave away.
+    Grid(Grid &&other) noexcept
+    : m_top_left{std::exchange(other.m_top_left, Coord2D{0, 0})},
+      m_bottom_right{std::exchange(other.m_bottom_right, Coord2D{-1, -1})},
+      m_layout{std::exchange(other.m_layout, Layout{})},
+      m_cells{std::exchange(other.m_cells, {})}
     {}
 
-    Grid(const Grid& other) 
+    Grid(const Grid& other)
     : m_top_left{other.m_top_left},
       m_bottom_right{other.m_bottom_right},
-      m_map{other.m_map}
+      m_layout{other.m_layout},
+      m_cells{other.m_cells}
     {}
 
     Grid(int width, int height)
-    : m_top_left{0, 0}, m_bottom_right{width - 1, height - 1} {}
-
-    Grid() : m_top_left{0, 0}, m_bottom_right{-1, -1}, m_map{} {}
+    : m_top_left{0, 0}, m_bottom_right{width - 1, height - 1},
+      m_layout{width, height},
+      m_cells(m_layout.size()) {}
+
+    Grid() : m_top_left{0, 0}, m_bottom_right{-1, -1}, m_layout{}, m_cells{} {}
+
+    Grid &operator=(const Grid &) = default;
+    Grid &operator=(Grid &&other) noexcept {
+      if (this != &other) {
+        m_top_left = std::exchange(other.m_top_left, Coord2D{0, 0});
+        m_bottom_right = std::exchange(other.m_bottom_right, Coord2D{-1, -1});
+        m_layout = std::exchange(other.m_layout, Layout{});
+        m_cells = std::exchange(other.m_cells, {});
+      }
+      return *this;
+    }
 
     void set(Coord2D c, Cell val);
     Cell operator[] (Coord2D c) const;
@@ -36,35 +60,58 @@ namespace grid {
 
     std::pair<Coord2D, Coord2D> bounds() const { return std::make_pair(m_top_left, m_bottom_right); }
 
+    int width() const { return m_bottom_right.x - m_top_left.x + 1; }
+    int height() const { return m_bottom_right.y - m_top_left.y + 1; }
+
+    // Cells of row `y`, left to right.
+    std::span<const Cell> row(int y) const requires Layout::k_contiguous_rows {
+      return {m_cells.data() + index(Coord2D{m_top_left.x, y}), static_cast<size_t>(width())};
+    }
+    std::span<Cell> row(int y) requires Layout::k_contiguous_rows {
+      return {m_cells.data() + index(Coord2D{m_top_left.x, y}), static_cast<size_t>(width())};
+    }
+
+    // All cells in storage order, i.e. indexed by index().
+    std::span<const Cell> cells() const { return m_cells; }
+    std::span<Cell> cells() { return m_cells; }
+
+    // Index-based access for hot loops: look a cell up once with index(), then
+    // walk with step() instead of recomputing the index from coordinates.
+    // step() does no bounds checking, the neighbour must be inside the grid.
+    size_t index(Coord2D c) const {
+      return m_layout.index(c.x - m_top_left.x, c.y - m_top_left.y);
+    }
+    size_t step(size_t idx, Dir2D dir) const { return m_layout.step(idx, dir); }
+    Cell at_index(size_t idx) const { return m_cells[idx]; }
+
   private:
     Coord2D m_top_left{0, 0};
     Coord2D m_bottom_right{-1, -1};
-    std::map<Coord2D, Cell> m_map{};
+    Layout m_layout{};
+    std::vector<Cell> m_cells{};
   };
 
-  template <class Cell>
-  void Grid<Cell>::set(Coord2D c, Cell val) {
+  template <class Cell, class Layout>
+  void Grid<Cell, Layout>::set(Coord2D c, Cell val) {
     if (!is_within_bounds(c)) {
       throw std::runtime_error("Can't grow");
     }
-    m_map[c] = val;
+    m_cells[index(c)] = val;
   }
 
-  template <class Cell>
-  Cell Grid<Cell>::operator[](Coord2D c) const {
-    if (m_map.contains(c)) {
-      return m_map.at(c);
-    }
-    if (is_within_bounds(c)) {
-      return Cell{};
+  template <class Cell, class Layout>
+  Cell Grid<Cell, Layout>::operator[](Coord2D c) const {
+    if (!is_within_bounds(c)) {
+      return Cell::out_of_bounds();
     }
-    return Cell::out_of_bounds();
+    return m_cells[index(c)];
   }
 
-  template <class Cell>
-  bool Grid<Cell>::is_within_bounds(Coord2D c) const {
-    return c.x >= m_top_left.x && c.x <= m_bottom_right.x &&
-           c.y >= m_top_left.y && c.y <= m_bottom_right.y;
+  template <class Cell, class Layout>
+  bool Grid<Cell, Layout>::is_within_bounds(Coord2D c) const {
+    // Unsigned comparison folds the lower and upper bound checks into one.
+    return static_cast<unsigned>(c.x - m_top_left.x) < static_cast<unsigned>(width()) &&
+           static_cast<unsigned>(c.y - m_top_left.y) < static_cast<unsigned>(height());
   }
 
 }
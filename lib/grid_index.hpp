@@ -0,0 +1,84 @@
+#pragma once
+
+#include "coord.h"
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace grid {
+
+  // A cell position as a single 32-bit offset. Offsets come from an
+  // IndexSpace, and only mean something together with the space they came
+  // from.
+  struct GridIndex {
+    uint32_t offset{0};
+
+    auto operator<=>(const GridIndex &) const = default;
+  };
+
+  // Row-major numbering of a rectangle plus a one-cell border all around it.
+  // Stepping in any direction is one add of a precomputed stride, and since
+  // the border is part of the space, stepping off the rectangle lands on a
+  // border cell instead of wrapping to the other side. Per-cell data lives in
+  // plain vectors of size(), with the border cells set to whatever means
+  // "outside" for the puzzle.
+  class IndexSpace {
+  public:
+    IndexSpace() = default;
+    explicit IndexSpace(std::pair<Coord2D, Coord2D> bounds)
+    : m_origin{bounds.first - Coord2D{1, 1}},
+      m_row{bounds.second.x - bounds.first.x + 3},
+      m_rows{bounds.second.y - bounds.first.y + 3},
+      m_strides{-m_row, 1, m_row, -1} {}
+
+    size_t size() const { return static_cast<size_t>(m_row) * m_rows; }
+
+    // `c` must be inside the bounds or on the border ring around them.
+    GridIndex index(Coord2D c) const {
+      return {static_cast<uint32_t>((c.y - m_origin.y) * m_row + (c.x - m_origin.x))};
+    }
+
+    Coord2D coord(GridIndex i) const {
+      int offset = static_cast<int>(i.offset);
+      return {m_origin.x + offset % m_row, m_origin.y + offset / m_row};
+    }
+
+    // Only valid from cells inside the bounds; from a border cell the step
+    // may leave the space.
+    GridIndex step(GridIndex i, Dir2D dir) const {
+      return {i.offset + static_cast<uint32_t>(m_strides[dir.idx()])};
+    }
+
+    int32_t stride(Dir2D dir) const { return m_strides[dir.idx()]; }
+
+    bool is_border(Coord2D c) const {
+      return c.x == m_origin.x || c.y == m_origin.y || c.x == m_origin.x + m_row - 1 || c.y == m_origin.y + m_rows - 1;
+    }
+
+    // A size() vector holding fn(c) for every cell of `g` and `border`
+    // everywhere around it.
+    template <class SomeGrid, class Fn, class T = std::invoke_result_t<Fn, typename SomeGrid::value_t>>
+    std::vector<T> flatten(const SomeGrid &g, Fn fn, T border) const {
+      std::vector<T> result(size(), border);
+      for (int y = 1; y < m_rows - 1; ++y) {
+        for (int x = 1; x < m_row - 1; ++x) {
+          Coord2D c{m_origin.x + x, m_origin.y + y};
+          result[static_cast<size_t>(y) * m_row + x] = fn(g[c]);
+        }
+      }
+      return result;
+    }
+
+  private:
+    Coord2D m_origin{0, 0};
+    int32_t m_row{0};
+    int32_t m_rows{0};
+    std::array<int32_t, 4> m_strides{};
+  };
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "coord.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Storage layouts for grid::Grid. A layout maps a cell offset from the grid's
+// top-left corner to a slot in a flat array, and knows how to step from one
+// slot to its neighbour without going back through coordinates.
+namespace grid::layout {
+
+  // Classic row-major order. Horizontal neighbours are adjacent, vertical ones
+  // sit a whole row apart.
+  struct RowMajor {
+    static constexpr bool k_contiguous_rows = true;
+
+    RowMajor() = default;
+    RowMajor(int width, int height)
+    : m_width{width}, m_height{height}, m_strides{-width, 1, width, -1} {}
+
+    size_t size() const { return static_cast<size_t>(m_width) * m_height; }
+
+    size_t index(int x, int y) const { return static_cast<size_t>(y) * m_width + x; }
+
+    size_t step(size_t idx, Dir2D dir) const { return idx + m_strides[dir.idx()]; }
+
+  private:
+    int m_width{0};
+    int m_height{0};
+    // Offset to the neighbour in each direction, indexed like Dir2D.
+    std::array<ptrdiff_t, 4> m_strides{};
+  };
+
+  // Z-order: the bits of x and y are interleaved (x in even bits, y in odd
+  // bits), so cells close in 2D mostly stay close in memory in every
+  // direction. Storage is sized up to the Morton index of the bottom-right
+  // cell, which wastes space for very elongated grids.
+  struct Morton {
+    static constexpr bool k_contiguous_rows = false;
+
+    static constexpr uint64_t k_x_mask = 0x5555555555555555ull;
+    static constexpr uint64_t k_y_mask = 0xAAAAAAAAAAAAAAAAull;
+
+    Morton() = default;
+    Morton(int width, int height)
+    : m_size{width > 0 && height > 0 ? encode(width - 1, height - 1) + 1 : 0} {}
+
+    size_t size() const { return m_size; }
+
+    size_t index(int x, int y) const { return encode(x, y); }
+
+    // Adding one to a dilated coordinate: set all the other coordinate's bits
+    // so the carry ripples through them, then mask them out again.
+    size_t step(size_t idx, Dir2D dir) const {
+      uint64_t i = idx;
+      switch (dir.m_val) {
+      case Dir2D::Up: return (((i & k_y_mask) - 1) & k_y_mask) | (i & k_x_mask);
+      case Dir2D::Right: return (((i | k_y_mask) + 1) & k_x_mask) | (i & k_y_mask);
+      case Dir2D::Down: return (((i | k_x_mask) + 1) & k_y_mask) | (i & k_x_mask);
+      case Dir2D::Left: return (((i & k_x_mask) - 1) & k_x_mask) | (i & k_y_mask);
+      }
+      return idx;
+    }
+
+    static uint64_t encode(uint32_t x, uint32_t y) {
+#if defined(__BMI2__)
+      return _pdep_u64(x, k_x_mask) | _pdep_u64(y, k_y_mask);
+#else
+      return dilate(x) | (dilate(y) << 1);
+#endif
+    }
+
+  private:
+    static uint64_t dilate(uint32_t v) {
+      uint64_t r = v;
+      r = (r | (r << 16)) & 0x0000FFFF0000FFFFull;
+      r = (r | (r << 8)) & 0x00FF00FF00FF00FFull;
+      r = (r | (r << 4)) & 0x0F0F0F0F0F0F0F0Full;
+      r = (r | (r << 2)) & 0x3333333333333333ull;
+      r = (r | (r << 1)) & 0x5555555555555555ull;
+      return r;
+    }
+
+    size_t m_size{0};
+  };
+
+}
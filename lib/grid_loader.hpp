@@ -0,0 +1,133 @@
+#pragma once
+
+#include "coord.h"
+#include "grid.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace grid {
+
+  // Character -> cell translation for parse_grid(). Characters registered as
+  // markers are stored as their cell too, and their positions are reported.
+  template <class Cell>
+  class CharTable {
+  public:
+    enum class Kind : uint8_t { Invalid, Plain, Marker };
+
+    CharTable &cell(char c, Cell val) {
+      m_cells[index(c)] = val;
+      m_kinds[index(c)] = Kind::Plain;
+      return *this;
+    }
+
+    CharTable &marker(char c, Cell val) {
+      m_cells[index(c)] = val;
+      m_kinds[index(c)] = Kind::Marker;
+      return *this;
+    }
+
+    Kind kind(char c) const { return m_kinds[index(c)]; }
+    const Cell &translate(char c) const { return m_cells[index(c)]; }
+
+  private:
+    static size_t index(char c) { return static_cast<uint8_t>(c); }
+
+    std::array<Cell, 256> m_cells{};
+    std::array<Kind, 256> m_kinds{};
+  };
+
+  template <class Cell, class Layout = layout::RowMajor>
+  struct ParsedGrid {
+    Grid<Cell, Layout> grid;
+    std::vector<std::pair<char, Coord2D>> markers;
+    // Whatever follows the blank line ending the grid, if any.
+    std::string_view rest;
+
+    std::optional<Coord2D> marker(char c) const {
+      for (auto [m, coord] : markers) {
+        if (m == c) {
+          return coord;
+        }
+      }
+      return {};
+    }
+  };
+
+  // Parses a rectangular block of lines into a grid, translating every
+  // character through `table`. The grid ends at the first empty line or at the
+  // end of input. Lines are located with memchr and every row is written
+  // straight into the grid storage, with no intermediate strings.
+  template <class Cell, class Layout = layout::RowMajor>
+  ParsedGrid<Cell, Layout> parse_grid(std::string_view input, const CharTable<Cell> &table) {
+    using Kind = typename CharTable<Cell>::Kind;
+
+    auto next_line = [](std::string_view &in) {
+      const void *nl = std::memchr(in.data(), '\n', in.size());
+      size_t len = nl ? static_cast<const char *>(nl) - in.data() : in.size();
+      std::string_view line = in.substr(0, len);
+      in.remove_prefix(nl ? len + 1 : len);
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      return line;
+    };
+
+    // First pass only finds the line boundaries, so the grid can be sized once.
+    std::vector<std::string_view> lines{};
+    std::string_view in{input};
+    while (!in.empty()) {
+      std::string_view line = next_line(in);
+      if (line.empty()) {
+        break;
+      }
+      if (!lines.empty() && line.size() != lines.front().size()) {
+        throw std::runtime_error(std::format("Line {} has width {}, expected {}", lines.size() + 1, line.size(), lines.front().size()));
+      }
+      lines.push_back(line);
+    }
+
+    // Grids and coordinates are int-sized; check once, then cast.
+    size_t num_cols = lines.empty() ? 0 : lines.front().size();
+    if (num_cols > std::numeric_limits<int>::max() || lines.size() > std::numeric_limits<int>::max()) {
+      throw std::runtime_error(std::format("Grid of {}x{} is too large", num_cols, lines.size()));
+    }
+    int width = static_cast<int>(num_cols);
+    int height = static_cast<int>(lines.size());
+    ParsedGrid<Cell, Layout> result{Grid<Cell, Layout>(width, height), {}, in};
+
+    for (int y = 0; y < height; ++y) {
+      std::string_view line = lines[y];
+      std::span<Cell> row{};
+      if constexpr (Layout::k_contiguous_rows) {
+        row = result.grid.row(y);
+      }
+      for (int x = 0; x < width; ++x) {
+        char c = line[x];
+        Kind kind = table.kind(c);
+        if (kind == Kind::Invalid) [[unlikely]] {
+          throw std::runtime_error(std::format("Unexpected char '{}' at {}", c, Coord2D{x, y}));
+        }
+        if (kind == Kind::Marker) [[unlikely]] {
+          result.markers.emplace_back(c, Coord2D{x, y});
+        }
+        if constexpr (Layout::k_contiguous_rows) {
+          row[x] = table.translate(c);
+        } else {
+          result.grid.set({x, y}, table.translate(c));
+        }
+      }
+    }
+    return result;
+  }
+
+}
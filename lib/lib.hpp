@@ -1,19 +1,19 @@
 #pragma once
 
-#include "indicators/block_progress_bar.hpp"
+#include "num_scan.hpp"
 
 #include <algorithm>
-#include <algorithm>
+#include <array>
 #include <cstring>
 #include <functional>
 #include <iostream>
 #include <iterator>
-#include <iterator>
+#include <optional>
 #include <ostream>
 #include <print>
-#include <regex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std::literals::string_literals;
@@ -22,8 +22,6 @@ template <class Container, typename T = typename Container::value_type> void dum
   std::copy(cont.begin(), cont.end(), std::ostream_iterator<T>(std::cout, " "));
 }
 
-std::unique_ptr<indicators::BlockProgressBar, std::function<void(indicators::BlockProgressBar*)>> make_bar(const std::string &prefix, int max_progress);
-
 inline void cls() {
   std::cout << "\033[H\033[2J";
 }
@@ -41,56 +39,28 @@ inline std::vector<std::string> read_all_lines() {
   return result;
 }
 
-template <typename NumType>
-struct NumParser {
-  static NumType parse(const std::string&) {}
-};
-
-template <>
-struct NumParser<int> {
-  static int parse(const std::string& s) {
-    return int{std::stoi(s)};
-  }
-};
-
-template <>
-struct NumParser<long> {
-  static long parse(const std::string& s) {
-    return long{std::stol(s)};
-  }
-};
-
 template <class Value>
-inline std::vector<Value> parse_all_numbers(const std::string& str) {
+inline std::vector<Value> parse_all_numbers(std::string_view str) {
   std::vector<Value> result{};
-
-  std::regex re{"-?\\d+"};
-  std::sregex_iterator search_begin{str.begin(), str.end(), re}, search_end{};
-
-  for (auto it = search_begin; it != search_end; ++it) {
-    std::smatch match = *it;
-    result.push_back(NumParser<Value>::parse(match.str(0)));
-  }
+  scan_numbers(str, result);
   return result;
 }
 
 template <class Value, auto num>
-inline std::array<Value, num> parse_n_numbers(const std::string& str, bool ignore_overflow = false) {
+inline std::array<Value, num> parse_n_numbers(std::string_view str, bool ignore_overflow = false) {
   std::array<Value, num> result{};
 
-  std::regex re{"-?\\d+"};
-  std::sregex_iterator search_begin{str.begin(), str.end(), re}, search_end{};
-
-  int found{};
-  for (auto it = search_begin; it != search_end; ++it, ++found) {
-    if (found > num && !ignore_overflow) {
-      throw std::runtime_error(std::format("Expected only {} elements in input '{}'", num, str));
+  NumberScanner<Value> scanner{str};
+  size_t found{};
+  for (; found < num; ++found) {
+    std::optional<Value> val = scanner.next();
+    if (!val) {
+      throw std::runtime_error(std::format("Expected {} elements, found {}: input='{}'", num, found, str));
     }
-    std::smatch match = *it;
-    result[found] = NumParser<Value>::parse(match.str(0));
+    result[found] = *val;
   }
-  if (found < num) {
-    throw std::runtime_error(std::format("Expected {} elements, found {}: input='{}'", num, found, str));
+  if (!ignore_overflow && scanner.next()) {
+    throw std::runtime_error(std::format("Expected only {} elements in input '{}'", num, str));
   }
   return result;
 }
@@ -0,0 +1,101 @@
+#include "line_buffer.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+  // Bit i set when p[i] == '\n', for the 64 bytes at p.
+  uint64_t newline_mask(const char *p) {
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    uint64_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), nl)));
+    uint64_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32)), nl)));
+    return lo | (hi << 32);
+#elif defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    uint64_t result{0};
+    for (int i = 0; i < 4; ++i) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * 16));
+      result |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))) << (i * 16);
+    }
+    return result;
+#else
+    uint64_t result{0};
+    for (int i = 0; i < 64; ++i) {
+      result |= static_cast<uint64_t>(p[i] == '\n') << i;
+    }
+    return result;
+#endif
+  }
+
+  // Calls fn(offset) for every '\n' in text, in order. Lines are mostly
+  // shorter than a block, so this beats calling memchr once per line.
+  template <class Fn>
+  void for_each_newline(std::string_view text, Fn fn) {
+    const char *data = text.data();
+    size_t i = 0;
+    for (; i + 64 <= text.size(); i += 64) {
+      for (uint64_t bits = newline_mask(data + i); bits; bits &= bits - 1) {
+        fn(i + std::countr_zero(bits));
+      }
+    }
+    for (; i < text.size(); ++i) {
+      if (data[i] == '\n') {
+        fn(i);
+      }
+    }
+  }
+}
+
+LineBuffer LineBuffer::from_stdin() {
+  return LineBuffer{MappedInput::from_stdin()};
+}
+
+LineBuffer LineBuffer::from_file(const std::string &path) {
+  return LineBuffer{MappedInput::from_file(path)};
+}
+
+LineBuffer::LineBuffer(MappedInput input) : m_input{std::move(input)}, m_text{m_input->view()} {
+  index();
+}
+
+LineBuffer LineBuffer::over(std::string_view text) {
+  LineBuffer result{};
+  result.m_text = text;
+  result.index();
+  return result;
+}
+
+std::span<const std::string_view> LineBuffer::until_blank() const {
+  auto blank = std::ranges::find_if(m_lines, &std::string_view::empty);
+  return std::span{m_lines}.first(blank - m_lines.begin());
+}
+
+std::span<const std::string_view> LineBuffer::after_blank() const {
+  size_t skip = until_blank().size();
+  return std::span{m_lines}.subspan(std::min(skip + 1, m_lines.size()));
+}
+
+void LineBuffer::index() {
+  TRACE_SCOPE("LineBuffer::index");
+  m_lines.clear();
+  size_t line_start{0};
+  for_each_newline(m_text, [&](size_t eol) {
+    m_lines.push_back(m_text.substr(line_start, eol - line_start));
+    line_start = eol + 1;
+  });
+  if (line_start < m_text.size()) {
+    m_lines.push_back(m_text.substr(line_start));
+  }
+}
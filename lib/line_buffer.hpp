@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mapped_input.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The input split into lines without copying them: one contiguous buffer
+// (a MappedInput, or text owned by the caller) and a string_view per line
+// into it. Lines are split like std::getline splits them: a final '\n'
+// doesn't start another, empty, line, and '\r' is kept.
+class LineBuffer {
+public:
+  // Must be called before anything else reads std::cin, like
+  // MappedInput::from_stdin.
+  static LineBuffer from_stdin();
+  static LineBuffer from_file(const std::string &path);
+  explicit LineBuffer(MappedInput input);
+
+  // Indexes text owned by someone else; it must outlive the LineBuffer.
+  static LineBuffer over(std::string_view text);
+
+  size_t size() const { return m_lines.size(); }
+  bool empty() const { return m_lines.empty(); }
+  std::string_view operator[](size_t i) const { return m_lines[i]; }
+  std::string_view at(size_t i) const { return m_lines.at(i); }
+
+  std::span<const std::string_view> lines() const { return m_lines; }
+  auto begin() const { return m_lines.begin(); }
+  auto end() const { return m_lines.end(); }
+
+  // The lines before the first empty one, and the ones after it; for the
+  // usual "grid, blank line, more input" layout.
+  std::span<const std::string_view> until_blank() const;
+  std::span<const std::string_view> after_blank() const;
+
+  std::string_view text() const { return m_text; }
+
+private:
+  LineBuffer() = default;
+  void index();
+
+  std::optional<MappedInput> m_input{};
+  std::string_view m_text{};
+  std::vector<std::string_view> m_lines{};
+};
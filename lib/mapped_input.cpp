@@ -0,0 +1,120 @@
+#include "mapped_input.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  [[noreturn]] void throw_errno(std::string_view what, const std::string &name) {
+    throw std::runtime_error(std::format("{} '{}': {}", what, name, std::strerror(errno)));
+  }
+
+  bool is_mappable(int fd, const struct stat &st) {
+    return S_ISREG(st.st_mode) && st.st_size > 0 && ::lseek(fd, 0, SEEK_CUR) == 0;
+  }
+}
+
+MappedInput MappedInput::from_stdin() {
+  return from_fd(STDIN_FILENO, "<stdin>");
+}
+
+bool MappedInput::stdin_is_mappable() {
+  struct stat st{};
+  return ::fstat(STDIN_FILENO, &st) == 0 && is_mappable(STDIN_FILENO, st);
+}
+
+MappedInput MappedInput::from_file(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw_errno("Can't open", path);
+  }
+  try {
+    MappedInput result{from_fd(fd, path)};
+    ::close(fd);
+    return result;
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+MappedInput MappedInput::from_fd(int fd, const std::string &name) {
+  MappedInput result{};
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    throw_errno("Can't stat", name);
+  }
+
+  if (is_mappable(fd, st)) {
+    void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      result.m_data = static_cast<const char *>(addr);
+      result.m_size = st.st_size;
+      result.m_mapped = true;
+      return result;
+    }
+  }
+
+  // Not mappable (pipe, tty, partially consumed file): read it all in once.
+  constexpr size_t k_chunk = 1 << 20;
+  size_t used{0};
+  while (true) {
+    result.m_owned.resize(used + k_chunk);
+    ssize_t got = ::read(fd, result.m_owned.data() + used, k_chunk);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_errno("Can't read", name);
+    }
+    if (got == 0) {
+      break;
+    }
+    used += got;
+  }
+  result.m_owned.resize(used);
+  result.m_data = result.m_owned.data();
+  result.m_size = used;
+  return result;
+}
+
+MappedInput::MappedInput(MappedInput &&other) noexcept
+: m_data{std::exchange(other.m_data, nullptr)},
+  m_size{std::exchange(other.m_size, 0)},
+  m_mapped{std::exchange(other.m_mapped, false)},
+  m_owned{std::move(other.m_owned)}
+{}
+
+MappedInput &MappedInput::operator=(MappedInput &&other) noexcept {
+  if (this != &other) {
+    release();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_mapped = std::exchange(other.m_mapped, false);
+    m_owned = std::move(other.m_owned);
+  }
+  return *this;
+}
+
+MappedInput::~MappedInput() {
+  release();
+}
+
+void MappedInput::release() {
+  if (m_mapped) {
+    ::munmap(const_cast<char *>(m_data), m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+  m_owned.clear();
+}
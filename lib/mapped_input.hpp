@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The whole input as one read-only buffer. Files (including stdin redirected
+// from a file, the usual `dayNN < input.txt`) are mmapped; pipes and terminals
+// are read once, in large chunks, into an owned buffer.
+class MappedInput {
+public:
+  // Must be called before anything else reads std::cin, since iostreams
+  // buffer ahead of the file descriptor.
+  static MappedInput from_stdin();
+  static MappedInput from_file(const std::string &path);
+
+  // Whether from_stdin() would map stdin rather than read it, i.e. stdin is
+  // a regular file nothing has read from yet. A mapped file can be parsed in
+  // chunks on the pool, while a pipe is better read a line at a time, so
+  // days that can also stream use this to pick between the two.
+  static bool stdin_is_mappable();
+
+  MappedInput(MappedInput &&other) noexcept;
+  MappedInput &operator=(MappedInput &&other) noexcept;
+  MappedInput(const MappedInput &) = delete;
+  MappedInput &operator=(const MappedInput &) = delete;
+  ~MappedInput();
+
+  std::string_view view() const { return {m_data, m_size}; }
+  const char *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool is_mapped() const { return m_mapped; }
+
+private:
+  MappedInput() = default;
+  static MappedInput from_fd(int fd, const std::string &name);
+  void release();
+
+  const char *m_data{nullptr};
+  size_t m_size{0};
+  bool m_mapped{false};
+  std::vector<char> m_owned{};
+};
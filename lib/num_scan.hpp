@@ -0,0 +1,119 @@
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace num_scan_detail {
+
+  inline bool is_digit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+  // The first digit in [p, end), or end. Separators between numbers are
+  // usually short, but headers and prose in front of them aren't, so the
+  // skip looks at 16 bytes at a time where SSE2 is around.
+  inline const char *find_digit(const char *p, const char *end) {
+#if defined(__SSE2__)
+    // Shifted so that '0'..'9' become the ten smallest signed bytes.
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - '0'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(0x80 + 10));
+    for (; end - p >= 16; p += 16) {
+      __m128i v = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), bias);
+      if (int digits = _mm_movemask_epi8(_mm_cmplt_epi8(v, limit))) {
+        return p + std::countr_zero(static_cast<unsigned>(digits));
+      }
+    }
+#endif
+    while (p != end && !is_digit(*p)) {
+      ++p;
+    }
+    return p;
+  }
+
+  // Throws what the matching std::sto* would, with `what` as the message.
+  template <class Value>
+  Value from_digits(std::string_view s, const char *what) {
+    Value result{};
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), result);
+    if (ec == std::errc::result_out_of_range) {
+      throw std::out_of_range(what);
+    }
+    if (ec != std::errc{} || ptr != s.data() + s.size()) {
+      throw std::invalid_argument(what);
+    }
+    return result;
+  }
+
+}
+
+// Converts one -?\d+ token.
+template <typename NumType>
+struct NumParser {
+  static NumType parse(std::string_view) {}
+};
+
+template <>
+struct NumParser<int> {
+  static int parse(std::string_view s) { return num_scan_detail::from_digits<int>(s, "stoi"); }
+};
+
+template <>
+struct NumParser<long> {
+  static long parse(std::string_view s) { return num_scan_detail::from_digits<long>(s, "stol"); }
+};
+
+template <>
+struct NumParser<long long> {
+  static long long parse(std::string_view s) { return num_scan_detail::from_digits<long long>(s, "stoll"); }
+};
+
+// Walks the integers in a piece of text, finding the same tokens as the
+// regex -?\d+: maximal digit runs, with a '-' right in front of one taken
+// as its sign. The text must outlive the scanner.
+template <class Value>
+class NumberScanner {
+public:
+  explicit NumberScanner(std::string_view text) : m_begin{text.data()}, m_pos{text.data()}, m_end{text.data() + text.size()} {}
+
+  std::optional<Value> next() {
+    const char *digits = num_scan_detail::find_digit(m_pos, m_end);
+    if (digits == m_end) {
+      m_pos = m_end;
+      return {};
+    }
+    const char *start = digits != m_begin && digits[-1] == '-' ? digits - 1 : digits;
+    m_pos = digits;
+    while (m_pos != m_end && num_scan_detail::is_digit(*m_pos)) {
+      ++m_pos;
+    }
+    return NumParser<Value>::parse(std::string_view{start, m_pos});
+  }
+
+  // What's left after the last number returned.
+  std::string_view rest() const { return {m_pos, m_end}; }
+
+private:
+  const char *m_begin;
+  const char *m_pos;
+  const char *m_end;
+};
+
+// Appends every number in `text` to `out` and returns how many there were.
+// Reusing `out` across calls keeps the scan allocation free.
+template <class Value>
+size_t scan_numbers(std::string_view text, std::vector<Value> &out) {
+  size_t before = out.size();
+  NumberScanner<Value> scanner{text};
+  while (auto num = scanner.next()) {
+    out.push_back(*num);
+  }
+  return out.size() - before;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "coord.h"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace grid {
+
+  // A "what-if" view of another grid: a handful of cells are overridden, every
+  // other read falls through to the base. The base is referenced, never
+  // copied, and the first InlineCapacity overrides live inside the overlay, so
+  // creating and throwing one away costs nothing beyond its own size.
+  //
+  // Cells are addressed the way the base is: by Coord2D for a Grid, or by an
+  // IndexSpace offset for a flattened vector of cells.
+  //
+  // Lookups scan the overrides linearly; meant for a few changed cells, not
+  // for rewriting large parts of the base.
+  template <class Base, class Key = Coord2D, size_t InlineCapacity = 4>
+  class Overlay {
+  public:
+    using value_t = std::remove_cvref_t<decltype(std::declval<const Base &>()[std::declval<Key>()])>;
+
+    explicit Overlay(const Base &base) : m_base{base} {}
+
+    void set(Key c, value_t val) {
+      if (!is_within_bounds(c)) {
+        throw std::runtime_error("Can't grow");
+      }
+      if (value_t *cell = find(c)) {
+        *cell = val;
+      } else if (m_inline_size < InlineCapacity) {
+        m_inline[m_inline_size++] = {c, val};
+      } else {
+        m_spill.emplace_back(c, val);
+      }
+    }
+
+    value_t operator[](Key c) const {
+      if (const value_t *cell = find(c)) {
+        return *cell;
+      }
+      return m_base[c];
+    }
+
+    bool is_within_bounds(Key c) const {
+      if constexpr (requires { m_base.is_within_bounds(c); }) {
+        return m_base.is_within_bounds(c);
+      } else {
+        return c < m_base.size();
+      }
+    }
+
+    std::pair<Coord2D, Coord2D> bounds() const
+      requires requires(const Base &b) { b.bounds(); }
+    {
+      return m_base.bounds();
+    }
+
+    // Drops all overrides, keeping any spill capacity for the next what-if.
+    void clear() {
+      m_inline_size = 0;
+      m_spill.clear();
+    }
+
+    size_t num_overrides() const { return m_inline_size + m_spill.size(); }
+    const Base &base() const { return m_base; }
+
+  private:
+    using entry_t = std::pair<Key, value_t>;
+
+    const value_t *find(Key c) const {
+      // A fixed trip count, so the scan unrolls; overrides only spill once
+      // the inline ones are full.
+      for (size_t i = 0; i < InlineCapacity; ++i) {
+        if (i == m_inline_size) {
+          return nullptr;
+        }
+        if (m_inline[i].first == c) {
+          return &m_inline[i].second;
+        }
+      }
+      for (const auto &entry : m_spill) {
+        if (entry.first == c) {
+          return &entry.second;
+        }
+      }
+      return nullptr;
+    }
+
+    value_t *find(Key c) {
+      return const_cast<value_t *>(std::as_const(*this).find(c));
+    }
+
+    const Base &m_base;
+    size_t m_inline_size{0};
+    std::array<entry_t, InlineCapacity> m_inline{};
+    std::vector<entry_t> m_spill{};
+  };
+
+}
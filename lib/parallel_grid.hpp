@@ -0,0 +1,103 @@
+#pragma once
+
+#include "coord.h"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace grid {
+
+  // A run of rows handed to one task. Rows [begin, end) belong to the band:
+  // only it writes them. [halo_begin, halo_end) adds up to `halo` rows on each
+  // side, clipped to the grid, for stencils that need to read the
+  // neighbouring rows as well.
+  struct RowBand {
+    size_t index;
+    int begin, end;
+    int halo_begin, halo_end;
+  };
+
+  struct ParallelOptions {
+    // Bands depend on the grid and band_rows only, never on the number of
+    // threads, so results are reproducible from one machine to another.
+    int band_rows = 16;
+    int halo = 0;
+    ThreadPool *pool = nullptr;
+  };
+
+  inline std::vector<RowBand> row_bands(std::pair<Coord2D, Coord2D> bounds, int band_rows, int halo = 0) {
+    auto [top_left, bottom_right] = bounds;
+    band_rows = std::max(band_rows, 1);
+    std::vector<RowBand> result{};
+    for (int y = top_left.y; y <= bottom_right.y; y += band_rows) {
+      int end = std::min(y + band_rows, bottom_right.y + 1);
+      result.push_back(RowBand{
+          result.size(), y, end,
+          std::max(y - halo, top_left.y), std::min(end + halo, bottom_right.y + 1),
+        });
+    }
+    return result;
+  }
+
+  namespace detail {
+    inline std::pair<Coord2D, Coord2D> bounds_of(std::pair<Coord2D, Coord2D> bounds) { return bounds; }
+
+    template <class SomeGrid>
+    std::pair<Coord2D, Coord2D> bounds_of(const SomeGrid &g) { return g.bounds(); }
+  }
+
+  // Calls fn(const RowBand &) for every band of `where` (a grid or a pair
+  // of corners) on the thread pool.
+  template <class Where, class Fn>
+  void parallel_for_bands(const Where &where, Fn &&fn, ParallelOptions opts = {}) {
+    std::vector<RowBand> bands = row_bands(detail::bounds_of(where), opts.band_rows, opts.halo);
+    ThreadPool &pool = opts.pool ? *opts.pool : ThreadPool::shared();
+    pool.run(bands.size(), [&](size_t i) { fn(bands[i]); });
+  }
+
+  // Calls fn(y) for every row. Rows of one band run in order on one thread;
+  // fn may write to row y and read anything that no other row writes.
+  template <class Where, class Fn>
+  void parallel_for_rows(const Where &where, Fn &&fn, ParallelOptions opts = {}) {
+    parallel_for_bands(where, [&](const RowBand &band) {
+      for (int y = band.begin; y < band.end; ++y) {
+        fn(y);
+      }
+    }, opts);
+  }
+
+  // Folds every cell into a per-band accumulator, acc = op(acc, coord, cell),
+  // starting each band from `init`, then combines the bands top to bottom with
+  // combine(acc, band_acc). `init` must be neutral for combine. The fold
+  // order is fixed, so even non-associative ops give the same answer on any
+  // number of threads.
+  template <class SomeGrid, class T, class CellOp, class Combine>
+  T parallel_reduce_cells(const SomeGrid &g, T init, CellOp op, Combine combine, ParallelOptions opts = {}) {
+    auto [top_left, bottom_right] = g.bounds();
+    std::vector<RowBand> bands = row_bands({top_left, bottom_right}, opts.band_rows, opts.halo);
+    std::vector<std::optional<T>> partial(bands.size());
+
+    ThreadPool &pool = opts.pool ? *opts.pool : ThreadPool::shared();
+    pool.run(bands.size(), [&](size_t i) {
+      T acc{init};
+      for (int y = bands[i].begin; y < bands[i].end; ++y) {
+        for (int x = top_left.x; x <= bottom_right.x; ++x) {
+          Coord2D c{x, y};
+          acc = op(std::move(acc), c, g[c]);
+        }
+      }
+      partial[i].emplace(std::move(acc));
+    });
+
+    T result{std::move(init)};
+    for (auto &acc : partial) {
+      result = combine(std::move(result), std::move(*acc));
+    }
+    return result;
+  }
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "profile.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Parsing of line-oriented input on the thread pool: the text is cut into
+// chunks that end on line breaks, each chunk is parsed on its own, and the
+// results come back in input order.
+namespace parse {
+
+  struct ChunkOptions {
+    // Chunks smaller than this aren't worth a task; small inputs end up as
+    // a single chunk parsed on the calling thread.
+    size_t min_chunk_bytes = 64 << 10;
+    ThreadPool *pool = nullptr;
+  };
+
+  // At most `max_chunks` pieces of about the same size, each ending right
+  // after a '\n' (or at the end of the text), together covering all of it.
+  inline std::vector<std::string_view> split_at_lines(std::string_view text, size_t max_chunks) {
+    std::vector<std::string_view> result{};
+    size_t target = text.size() / std::max<size_t>(max_chunks, 1) + 1;
+    while (!text.empty()) {
+      size_t eol = target < text.size() ? text.find('\n', target - 1) : std::string_view::npos;
+      size_t len = eol == std::string_view::npos ? text.size() : eol + 1;
+      result.push_back(text.substr(0, len));
+      text.remove_prefix(len);
+    }
+    return result;
+  }
+
+  namespace detail {
+    inline ThreadPool &pool_of(const ChunkOptions &opts) {
+      return opts.pool ? *opts.pool : ThreadPool::shared();
+    }
+  }
+
+  // `text` split for the pool: a few chunks per thread, to even out lines
+  // of different cost, but none much smaller than opts.min_chunk_bytes.
+  inline std::vector<std::string_view> line_chunks(std::string_view text, const ChunkOptions &opts = {}) {
+    size_t by_size = text.size() / std::max<size_t>(opts.min_chunk_bytes, 1) + 1;
+    return split_at_lines(text, std::min(detail::pool_of(opts).concurrency() * 4, by_size));
+  }
+
+  // Calls fn(i, chunks[i]) for every chunk, on the pool.
+  template <class Fn>
+  void for_each_chunk(std::span<const std::string_view> chunks, Fn &&fn, const ChunkOptions &opts = {}) {
+    detail::pool_of(opts).run(chunks.size(), [&](size_t i) { fn(i, chunks[i]); });
+  }
+
+  // Calls parse_line(line, out) for every line of `text`, with `out` the
+  // result vector of the line's chunk, and returns the chunk vectors in
+  // input order, for callers that can use them as they are. Lines are split
+  // like std::getline splits them. parse_line runs on several chunks at
+  // once, so it may only share state that is safe to read concurrently.
+  // Lines are views into `text`: parse them with parse::Parser::over to get
+  // errors that point into the whole input.
+  template <class T, class ParseLine>
+  std::vector<std::vector<T>> parse_line_chunks(std::string_view text, ParseLine &&parse_line, const ChunkOptions &opts = {}) {
+    TRACE_SCOPE("parse_line_chunks");
+    std::vector<std::string_view> chunks = line_chunks(text, opts);
+    std::vector<std::vector<T>> result(chunks.size());
+    for_each_chunk(chunks, [&](size_t i, std::string_view chunk) {
+      TRACE_SCOPE("parse chunk");
+      while (!chunk.empty()) {
+        size_t eol = chunk.find('\n');
+        parse_line(chunk.substr(0, eol), result[i]);
+        chunk.remove_prefix(eol == std::string_view::npos ? chunk.size() : eol + 1);
+      }
+    }, opts);
+    return result;
+  }
+
+  // parse_line_chunks, concatenated.
+  template <class T, class ParseLine>
+  std::vector<T> parse_lines(std::string_view text, ParseLine &&parse_line, const ChunkOptions &opts = {}) {
+    std::vector<std::vector<T>> chunks = parse_line_chunks<T>(text, std::forward<ParseLine>(parse_line), opts);
+    if (chunks.size() == 1) {
+      return std::move(chunks.front());
+    }
+    size_t total{0};
+    for (const auto &chunk : chunks) {
+      total += chunk.size();
+    }
+    std::vector<T> result{};
+    result.reserve(total);
+    for (auto &chunk : chunks) {
+      std::move(chunk.begin(), chunk.end(), std::back_inserter(result));
+    }
+    return result;
+  }
+
+}
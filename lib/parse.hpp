@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Small recursive-descent parsing over a string_view, grown out of day13's
+// MachineParser. A Parser is a position in the input; each primitive either
+// consumes what it expects or throws parse::Error. Nothing is copied:
+// words and lines come back as views into the input, and numbers are
+// converted in place.
+//
+// The parser doesn't track lines and columns as it goes; an error works
+// them out from its offset when it's thrown.
+namespace parse {
+
+  struct Error : std::runtime_error {
+    Error(int line_no, int col_no, const std::string &what)
+    : std::runtime_error(std::format("Error at line {}/col {} - {}", line_no, col_no, what)),
+      line_no{line_no}, col_no{col_no} {}
+
+    int line_no;
+    int col_no;
+  };
+
+  class Parser {
+  public:
+    explicit Parser(std::string_view input) : m_input{input}, m_pos{0}, m_end{input.size()} {}
+
+    // A parser over `part`, a view into `input`, that reports positions in
+    // the whole of `input`; for pieces parsed on their own, like the lines
+    // handed out by parse_lines.
+    static Parser over(std::string_view input, std::string_view part) {
+      size_t begin = part.data() - input.data();
+      if (part.data() < input.data() || begin + part.size() > input.size()) {
+        throw std::out_of_range("parse::Parser::over: part isn't a view into input");
+      }
+      Parser result{input};
+      result.m_pos = begin;
+      result.m_end = begin + part.size();
+      return result;
+    }
+
+    std::string_view rest() const { return m_input.substr(m_pos, m_end - m_pos); }
+    bool at_end() const { return m_pos == m_end; }
+    size_t offset() const { return m_pos; }
+
+    template <class... Args>
+    [[noreturn]] void fail(std::format_string<Args...> fmt, Args &&...args) const {
+      std::string_view before = m_input.substr(0, m_pos);
+      int line_no = 1 + static_cast<int>(std::ranges::count(before, '\n'));
+      size_t line_start = before.rfind('\n');
+      int col_no = 1 + static_cast<int>(line_start == std::string_view::npos ? m_pos : m_pos - line_start - 1);
+      throw Error(line_no, col_no, std::format(fmt, std::forward<Args>(args)...));
+    }
+
+    // Literals.
+
+    bool try_literal(std::string_view expected) {
+      if (!rest().starts_with(expected)) {
+        return false;
+      }
+      m_pos += expected.size();
+      return true;
+    }
+
+    void literal(std::string_view expected) {
+      if (!try_literal(expected)) {
+        fail("Expected '{}', got '{}'", expected, rest().substr(0, expected.size()));
+      }
+    }
+
+    // Numbers: an optional '-' and at least one digit.
+
+    template <class Num>
+    Num integer() {
+      std::string_view text = rest();
+      Num result{};
+      auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), result);
+      if (ec == std::errc::result_out_of_range) {
+        fail("Number out of range");
+      }
+      if (ec != std::errc{}) {
+        fail("No int found");
+      }
+      m_pos += ptr - text.data();
+      return result;
+    }
+
+    // Whitespace and line structure.
+
+    // Spaces, tabs and newlines.
+    void whitespace() {
+      while (!at_end() && std::isspace(static_cast<unsigned char>(m_input[m_pos]))) {
+        ++m_pos;
+      }
+    }
+
+    // Spaces and tabs only.
+    void blanks() {
+      while (!at_end() && (m_input[m_pos] == ' ' || m_input[m_pos] == '\t')) {
+        ++m_pos;
+      }
+    }
+
+    // A line break, or the end of the input.
+    void end_of_line() {
+      if (!at_end() && !try_literal("\n")) {
+        fail("Expected end of line, got '{}'", rest().substr(0, rest().find('\n')));
+      }
+    }
+
+    // Letters, digits and underscores, like \w+.
+    std::string_view word() {
+      size_t len = 0;
+      for (char c : rest()) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+          break;
+        }
+        ++len;
+      }
+      if (len == 0) {
+        fail("Expected a word, got '{}'", rest().substr(0, 1));
+      }
+      return take(len);
+    }
+
+    // The rest of the current line, consuming the line break.
+    std::string_view line() {
+      std::string_view result = take(std::min(rest().find('\n'), rest().size()));
+      end_of_line();
+      return result;
+    }
+
+    // Combinators.
+
+    // item(*this) at least once, with `separator` between the items.
+    template <class Item>
+    void separated(std::string_view separator, Item &&item) {
+      do {
+        std::invoke(item, *this);
+      } while (try_literal(separator));
+    }
+
+    template <class Item, class T = std::invoke_result_t<Item &, Parser &>>
+    std::vector<T> list(std::string_view separator, Item &&item) {
+      std::vector<T> result{};
+      separated(separator, [&](Parser &p) { result.push_back(std::invoke(item, p)); });
+      return result;
+    }
+
+    // A section that starts with `prefix`: parses it with body(*this) when
+    // the prefix is there, and consumes nothing otherwise.
+    template <class Body, class T = std::invoke_result_t<Body &, Parser &>>
+    auto optional(std::string_view prefix, Body &&body) {
+      if constexpr (std::is_void_v<T>) {
+        if (try_literal(prefix)) {
+          std::invoke(body, *this);
+          return true;
+        }
+        return false;
+      } else {
+        std::optional<T> result{};
+        if (try_literal(prefix)) {
+          result.emplace(std::invoke(body, *this));
+        }
+        return result;
+      }
+    }
+
+    // Calls fn(line) with a parser limited to each remaining line; fn has
+    // to consume the whole line.
+    template <class Fn>
+    void lines(Fn &&fn) {
+      while (!at_end()) {
+        size_t eol = std::min(rest().find('\n'), rest().size());
+        Parser line{*this, m_pos + eol};
+        std::invoke(fn, line);
+        if (!line.at_end()) {
+          line.fail("Unexpected '{}'", line.rest());
+        }
+        m_pos += eol;
+        end_of_line();
+      }
+    }
+
+    // The lines up to the next blank line (or the end), as a parser of their
+    // own; this one moves past them and the blank lines that follow.
+    Parser block() {
+      std::string_view text = rest();
+      size_t blank = text.find("\n\n");
+      size_t len = blank == std::string_view::npos ? text.size() : blank + 1;
+      Parser result{*this, m_pos + len};
+      m_pos += len;
+      while (try_literal("\n")) {
+      }
+      return result;
+    }
+
+    // Every remaining block, each parsed by fn(block).
+    template <class Fn>
+    void blocks(Fn &&fn) {
+      while (!at_end()) {
+        Parser b = block();
+        std::invoke(fn, b);
+      }
+    }
+
+  private:
+    // A parser over [parent's position, end) that still reports positions
+    // in the whole input.
+    Parser(const Parser &parent, size_t end) : m_input{parent.m_input}, m_pos{parent.m_pos}, m_end{end} {}
+
+    std::string_view take(size_t len) {
+      std::string_view result = m_input.substr(m_pos, len);
+      m_pos += len;
+      return result;
+    }
+
+    std::string_view m_input;
+    size_t m_pos;
+    size_t m_end;
+  };
+
+}
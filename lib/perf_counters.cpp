@@ -0,0 +1,107 @@
+#include "perf_counters.hpp"
+
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+  struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+  };
+
+  EventConfig config_of(PerfCounters::Event event) {
+    switch (event) {
+    case PerfCounters::Instructions: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+    case PerfCounters::Cycles: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+    case PerfCounters::CacheMisses: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+    case PerfCounters::BranchMisses: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+    case PerfCounters::TaskClock: return {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK};
+    case PerfCounters::PageFaults: return {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS};
+    case PerfCounters::ContextSwitches: return {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES};
+    default: return {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_DUMMY};
+    }
+  }
+
+  int perf_event_open(perf_event_attr &attr, int group_fd) {
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+  }
+}
+
+std::string_view PerfCounters::name(Event event) {
+  switch (event) {
+  case Instructions: return "instructions";
+  case Cycles: return "cycles";
+  case CacheMisses: return "cache-misses";
+  case BranchMisses: return "branch-misses";
+  case TaskClock: return "task-clock ns";
+  case PageFaults: return "page-faults";
+  case ContextSwitches: return "ctx-switches";
+  default: return "?";
+  }
+}
+
+PerfCounters::PerfCounters() {
+  m_hardware = open({Cycles, Instructions, CacheMisses, BranchMisses});
+  if (!m_hardware) {
+    open({TaskClock, PageFaults, ContextSwitches});
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  close();
+}
+
+bool PerfCounters::open(std::initializer_list<Event> events) {
+  for (Event event : events) {
+    EventConfig config = config_of(event);
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = config.type;
+    attr.config = config.config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = perf_event_open(attr, m_fds.empty() ? -1 : m_fds.front());
+    if (fd < 0) {
+      close();
+      return false;
+    }
+    m_fds.push_back(fd);
+    m_events.push_back(event);
+  }
+  return true;
+}
+
+void PerfCounters::close() {
+  for (int fd : m_fds) {
+    ::close(fd);
+  }
+  m_fds.clear();
+  m_events.clear();
+}
+
+PerfCounters::Sample PerfCounters::read() const {
+  Sample result{};
+  if (!ok()) {
+    return result;
+  }
+  // nr, time_enabled, time_running, then one value per event.
+  std::array<uint64_t, 3 + k_num_events> buf{};
+  if (::read(m_fds.front(), buf.data(), sizeof(buf)) < static_cast<ssize_t>((3 + m_events.size()) * sizeof(uint64_t))) {
+    return result;
+  }
+  uint64_t enabled = buf[1];
+  uint64_t running = buf[2];
+  for (size_t i = 0; i < m_events.size(); ++i) {
+    uint64_t value = buf[3 + i];
+    if (running > 0 && running < enabled) {
+      value = static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+    }
+    result[m_events[i]] = value;
+  }
+  return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// The calling thread's hardware counters, read through perf_event_open.
+// Containers and VMs often don't expose the PMU; the counters then fall back
+// to what the kernel counts in software. Counts are user space only, so
+// kernel.perf_event_paranoid=2 is enough.
+class PerfCounters {
+public:
+  enum Event : uint8_t {
+    Instructions,
+    Cycles,
+    CacheMisses,
+    BranchMisses,
+    TaskClock,
+    PageFaults,
+    ContextSwitches,
+    k_num_events,
+  };
+
+  using Sample = std::array<uint64_t, k_num_events>;
+
+  static std::string_view name(Event event);
+
+  // Opens the counters of the calling thread; check ok().
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool ok() const { return !m_fds.empty(); }
+  bool hardware() const { return m_hardware; }
+  const std::vector<Event> &events() const { return m_events; }
+
+  // Running totals since the counters were opened, scaled up if the kernel
+  // had to multiplex them; events that aren't counted stay 0.
+  Sample read() const;
+
+private:
+  bool open(std::initializer_list<Event> events);
+  void close();
+
+  bool m_hardware{false};
+  std::vector<Event> m_events{};
+  std::vector<int> m_fds{};
+};
@@ -0,0 +1,356 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace profile {
+
+  namespace {
+    constexpr size_t k_max_spans = 1 << 20;
+
+    // Written only by the owning thread, so plain load + store is enough;
+    // the atomics are for the report, which reads them from another thread.
+    struct Stat {
+      std::atomic<uint64_t> count{0};
+      std::atomic<uint64_t> total_ns{0};
+      std::atomic<uint64_t> max_ns{0};
+    };
+
+    void bump(std::atomic<uint64_t> &value, uint64_t n) {
+      value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct Span {
+      uint32_t id;
+      uint64_t begin_ns;
+      uint64_t end_ns;
+    };
+
+    struct ThreadData {
+      explicit ThreadData(size_t thread_no) : thread_no{thread_no} {}
+
+      size_t thread_no;
+      std::array<Stat, k_max_names> scopes{};
+      std::array<std::atomic<int64_t>, k_max_names> counters{};
+      std::unique_ptr<PerfCounters> perf{};
+      std::atomic<bool> software_perf{false};
+      std::array<std::array<std::atomic<uint64_t>, PerfCounters::k_num_events>, k_max_names> phases{};
+      std::mutex spans_mutex{};
+      std::vector<Span> spans{};
+      size_t dropped_spans{0};
+    };
+
+    struct Registry {
+      std::mutex mutex{};
+      std::vector<std::string> scope_names{};
+      std::vector<std::string> counter_names{};
+      std::vector<std::unique_ptr<ThreadData>> threads{};
+      uint64_t start_ns{now_ns()};
+      std::string trace_path{};
+    };
+
+    // Leaked on purpose, like the trace rings: the report runs from atexit.
+    Registry &registry() {
+      static Registry *registry = new Registry{};
+      return *registry;
+    }
+
+    thread_local ThreadData *t_data = nullptr;
+
+    // The profiler's own allocations happen inside whatever scope is current;
+    // this keeps alloc_stats from charging them to it.
+    class Unscoped {
+    public:
+      Unscoped() : m_saved{std::exchange(t_current_scope, k_no_scope)} {}
+      ~Unscoped() { t_current_scope = m_saved; }
+
+      Unscoped(const Unscoped &) = delete;
+      Unscoped &operator=(const Unscoped &) = delete;
+
+    private:
+      uint32_t m_saved;
+    };
+
+    ThreadData &this_thread() {
+      if (!t_data) [[unlikely]] {
+        Unscoped unscoped{};
+        Registry &reg = registry();
+        std::lock_guard lock{reg.mutex};
+        reg.threads.push_back(std::make_unique<ThreadData>(reg.threads.size()));
+        t_data = reg.threads.back().get();
+      }
+      return *t_data;
+    }
+
+    uint32_t id_of(std::vector<std::string> &names, const char *name) {
+      if (auto it = std::ranges::find(names, name); it != names.end()) {
+        return static_cast<uint32_t>(it - names.begin());
+      }
+      if (names.size() == k_max_names) {
+        throw std::length_error(std::format("More than {} profile names, can't add '{}'", k_max_names, name));
+      }
+      names.emplace_back(name);
+      return static_cast<uint32_t>(names.size() - 1);
+    }
+
+    std::string json_escape(std::string_view s) {
+      std::string result{};
+      for (char c : s) {
+        if (c == '"' || c == '\\') {
+          result.push_back('\\');
+        }
+        result.push_back(c);
+      }
+      return result;
+    }
+
+    int64_t counter_total(const Registry &reg, size_t id) {
+      int64_t total{0};
+      for (const auto &thread : reg.threads) {
+        total += thread->counters[id].load(std::memory_order_relaxed);
+      }
+      return total;
+    }
+
+    void write_trace(const Registry &reg, uint64_t end_ns) {
+      std::ofstream out{reg.trace_path};
+      if (!out) {
+        std::cerr << std::format("Can't write profile trace to '{}'\n", reg.trace_path);
+        return;
+      }
+      auto us = [&](uint64_t ns) { return (ns - reg.start_ns) / 1e3; };
+      out << std::fixed << std::setprecision(3);
+      out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+      const char *sep = "";
+      for (const auto &thread : reg.threads) {
+        out << sep << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->thread_no
+            << ", \"args\": {\"name\": \"thread " << thread->thread_no << "\"}}";
+        sep = ",\n";
+        std::lock_guard lock{thread->spans_mutex};
+        for (const Span &span : thread->spans) {
+          out << sep << "{\"name\": \"" << json_escape(reg.scope_names[span.id]) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+              << thread->thread_no << ", \"ts\": " << us(span.begin_ns) << ", \"dur\": " << (span.end_ns - span.begin_ns) / 1e3 << "}";
+        }
+      }
+      for (size_t id = 0; id < reg.counter_names.size(); ++id) {
+        out << sep << "{\"name\": \"" << json_escape(reg.counter_names[id]) << "\", \"ph\": \"C\", \"pid\": 1, \"ts\": "
+            << us(end_ns) << ", \"args\": {\"value\": " << counter_total(reg, id) << "}}";
+        sep = ",\n";
+      }
+      out << "\n]}\n";
+    }
+
+    // PerfCounters totals of the TRACE_PHASE scopes, in the order of `ids`.
+    std::string phase_table(const Registry &reg, std::span<const size_t> ids) {
+      using Sample = PerfCounters::Sample;
+      std::vector<Sample> totals(reg.scope_names.size());
+      Sample any{};
+      bool software{false};
+      for (const auto &thread : reg.threads) {
+        if (thread->software_perf.load(std::memory_order_relaxed)) {
+          software = true;
+        }
+        for (size_t id = 0; id < totals.size(); ++id) {
+          for (size_t e = 0; e < PerfCounters::k_num_events; ++e) {
+            uint64_t value = thread->phases[id][e].load(std::memory_order_relaxed);
+            totals[id][e] += value;
+            any[e] += value;
+          }
+        }
+      }
+      std::vector<PerfCounters::Event> columns{};
+      for (size_t e = 0; e < PerfCounters::k_num_events; ++e) {
+        if (any[e] > 0) {
+          columns.push_back(static_cast<PerfCounters::Event>(e));
+        }
+      }
+      if (columns.empty()) {
+        return {};
+      }
+      bool ipc = any[PerfCounters::Instructions] > 0 && any[PerfCounters::Cycles] > 0;
+
+      std::string text = std::format("{:<32}", software ? "phase (no PMU, software counters)" : "phase");
+      for (PerfCounters::Event event : columns) {
+        text += std::format(" {:>16}", PerfCounters::name(event));
+      }
+      text += ipc ? std::format(" {:>6}\n", "IPC") : "\n";
+      for (size_t id : ids) {
+        const Sample &total = totals[id];
+        if (std::ranges::all_of(total, [](uint64_t v) { return v == 0; })) {
+          continue;
+        }
+        text += std::format("{:<32}", reg.scope_names[id]);
+        for (PerfCounters::Event event : columns) {
+          text += std::format(" {:>16}", total[event]);
+        }
+        if (ipc && total[PerfCounters::Cycles] > 0) {
+          text += std::format(" {:>6.2f}", static_cast<double>(total[PerfCounters::Instructions]) / total[PerfCounters::Cycles]);
+        }
+        text += "\n";
+      }
+      return text;
+    }
+
+    void write_summary(const Registry &reg, uint64_t end_ns) {
+      struct Row {
+        size_t id;
+        std::string_view name;
+        uint64_t count{0};
+        uint64_t total_ns{0};
+        uint64_t max_ns{0};
+      };
+      std::vector<Row> rows(reg.scope_names.size());
+      size_t dropped{0};
+      for (size_t id = 0; id < rows.size(); ++id) {
+        rows[id].id = id;
+        rows[id].name = reg.scope_names[id];
+      }
+      for (const auto &thread : reg.threads) {
+        for (size_t id = 0; id < rows.size(); ++id) {
+          const Stat &stat = thread->scopes[id];
+          rows[id].count += stat.count.load(std::memory_order_relaxed);
+          rows[id].total_ns += stat.total_ns.load(std::memory_order_relaxed);
+          rows[id].max_ns = std::max(rows[id].max_ns, stat.max_ns.load(std::memory_order_relaxed));
+        }
+        std::lock_guard lock{thread->spans_mutex};
+        dropped += thread->dropped_spans;
+      }
+      std::ranges::sort(rows, std::greater{}, &Row::total_ns);
+
+      double wall_ms = (end_ns - reg.start_ns) / 1e6;
+      std::string text = std::format("\n=== Profile: {:.3f}ms wall, {} threads ===\n", wall_ms, reg.threads.size());
+      text += std::format("{:<32} {:>10} {:>12} {:>12} {:>12} {:>7}\n", "scope", "calls", "total ms", "mean us", "max us", "% wall");
+      for (const Row &row : rows) {
+        if (row.count == 0) {
+          continue;
+        }
+        double total_ms = row.total_ns / 1e6;
+        text += std::format("{:<32} {:>10} {:>12.3f} {:>12.3f} {:>12.3f} {:>6.1f}%\n", row.name, row.count, total_ms,
+                            row.total_ns / 1e3 / row.count, row.max_ns / 1e3, 100 * total_ms / wall_ms);
+      }
+      std::vector<size_t> ids{};
+      for (const Row &row : rows) {
+        ids.push_back(row.id);
+      }
+      text += phase_table(reg, ids);
+      if (!reg.counter_names.empty()) {
+        text += std::format("{:<32} {:>10}\n", "counter", "value");
+        for (size_t id = 0; id < reg.counter_names.size(); ++id) {
+          text += std::format("{:<32} {:>10}\n", reg.counter_names[id], counter_total(reg, id));
+        }
+      }
+      if (dropped > 0) {
+        text += std::format("({} scopes past the first {} per thread are missing from the trace)\n", dropped, k_max_spans);
+      }
+      std::cerr << text;
+    }
+
+    void report() {
+      uint64_t end_ns = now_ns();
+      Registry &reg = registry();
+      std::lock_guard lock{reg.mutex};
+      if (!reg.trace_path.empty()) {
+        write_trace(reg, end_ns);
+      }
+      write_summary(reg, end_ns);
+    }
+
+    [[maybe_unused]] const bool k_configured = [] {
+      const char *env = std::getenv("AOC_PROFILE");
+      if (!env || !*env) {
+        return false;
+      }
+      Registry &reg = registry();
+      if (std::string_view{env} != "summary") {
+        reg.trace_path = env;
+      }
+      std::atexit(report);
+      g_mode.store(Mode::Recording, std::memory_order_relaxed);
+      return true;
+    }();
+  }
+
+  void track_scopes() {
+    Mode off{Mode::Off};
+    g_mode.compare_exchange_strong(off, Mode::ScopesOnly, std::memory_order_relaxed);
+  }
+
+  std::string scope_name(uint32_t id) {
+    Registry &reg = registry();
+    std::lock_guard lock{reg.mutex};
+    return id < reg.scope_names.size() ? reg.scope_names[id] : std::string{};
+  }
+
+  uint32_t scope_id(const char *name) {
+    Unscoped unscoped{};
+    Registry &reg = registry();
+    std::lock_guard lock{reg.mutex};
+    return id_of(reg.scope_names, name);
+  }
+
+  uint32_t counter_id(const char *name) {
+    Unscoped unscoped{};
+    Registry &reg = registry();
+    std::lock_guard lock{reg.mutex};
+    return id_of(reg.counter_names, name);
+  }
+
+  void scope_done(uint32_t id, uint64_t begin_ns, uint64_t end_ns) {
+    ThreadData &data = this_thread();
+    Stat &stat = data.scopes[id];
+    uint64_t elapsed = end_ns - begin_ns;
+    bump(stat.count, 1);
+    bump(stat.total_ns, elapsed);
+    if (elapsed > stat.max_ns.load(std::memory_order_relaxed)) {
+      stat.max_ns.store(elapsed, std::memory_order_relaxed);
+    }
+    if (!registry().trace_path.empty()) {
+      Unscoped unscoped{};
+      std::lock_guard lock{data.spans_mutex};
+      if (data.spans.size() < k_max_spans) {
+        data.spans.push_back({id, begin_ns, end_ns});
+      } else {
+        ++data.dropped_spans;
+      }
+    }
+  }
+
+  PerfCounters::Sample phase_counters() {
+    if (!active()) {
+      return {};
+    }
+    ThreadData &data = this_thread();
+    if (!data.perf) [[unlikely]] {
+      Unscoped unscoped{};
+      data.perf = std::make_unique<PerfCounters>();
+      data.software_perf.store(data.perf->ok() && !data.perf->hardware(), std::memory_order_relaxed);
+    }
+    return data.perf->read();
+  }
+
+  void phase_done(uint32_t id, const PerfCounters::Sample &begin) {
+    PerfCounters::Sample end = phase_counters();
+    auto &totals = this_thread().phases[id];
+    for (size_t e = 0; e < PerfCounters::k_num_events; ++e) {
+      bump(totals[e], end[e] - begin[e]);
+    }
+  }
+
+  void counter_add(uint32_t id, int64_t n) {
+    std::atomic<int64_t> &counter = this_thread().counters[id];
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "perf_counters.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// Scoped timers and counters, aggregated per thread.
+//
+//   TRACE_SCOPE("parse");          // times the rest of the enclosing block
+//   COUNTER_ADD("cells visited", n);
+//   TRACE_PHASE("solve");          // a scope that also reads PerfCounters
+//
+// Scopes and counters with the same name are added up, wherever they are.
+// Nothing is recorded unless AOC_PROFILE is set: to "summary" for a table of
+// the totals on stderr at exit, or to a file name to also write every scope
+// as a Chrome trace (chrome://tracing, ui.perfetto.dev). A scope costs two
+// clock reads while profiling and a relaxed load otherwise; a phase adds a
+// read() syscall at each end, so it's for the coarse steps of a solution.
+// A phase's counters include the ThreadPool workers' share of any batch run
+// from inside it, so for a parallel phase they add up CPU work, not wall time.
+namespace profile {
+
+  inline constexpr size_t k_max_names = 256;
+  inline constexpr uint32_t k_no_scope = UINT32_MAX;
+
+  // Off unless AOC_PROFILE is set; ScopesOnly keeps t_current_scope up to
+  // date and records nothing.
+  enum class Mode : uint8_t { Off, ScopesOnly, Recording };
+  inline std::atomic<Mode> g_mode{Mode::Off};
+
+  // The innermost scope the thread is in, unless Off, and its innermost
+  // phase.
+  inline thread_local uint32_t t_current_scope = k_no_scope;
+  inline thread_local uint32_t t_current_phase = k_no_scope;
+
+  inline bool active() {
+    return g_mode.load(std::memory_order_relaxed) == Mode::Recording;
+  }
+
+  inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Switches Off to ScopesOnly, for tools that only want t_current_scope,
+  // like alloc_stats. Doesn't turn AOC_PROFILE's recording off.
+  void track_scopes();
+
+  // Ids for names; the same name always gets the same id.
+  uint32_t scope_id(const char *name);
+  uint32_t counter_id(const char *name);
+  std::string scope_name(uint32_t id);
+
+  void scope_done(uint32_t id, uint64_t begin_ns, uint64_t end_ns);
+  void counter_add(uint32_t id, int64_t n);
+
+  // This thread's PerfCounters, opened on first use; all 0 if not profiling.
+  PerfCounters::Sample phase_counters();
+  void phase_done(uint32_t id, const PerfCounters::Sample &begin);
+
+  class Scope {
+  public:
+    explicit Scope(uint32_t id) : m_id{id}, m_mode{g_mode.load(std::memory_order_relaxed)} {
+      if (m_mode != Mode::Off) {
+        m_parent = std::exchange(t_current_scope, id);
+      }
+      if (m_mode == Mode::Recording) {
+        m_begin = now_ns();
+      }
+    }
+    ~Scope() {
+      if (m_mode == Mode::Recording) {
+        scope_done(m_id, m_begin, now_ns());
+      }
+      if (m_mode != Mode::Off) {
+        t_current_scope = m_parent;
+      }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    uint32_t m_id;
+    Mode m_mode;
+    uint32_t m_parent{k_no_scope};
+    uint64_t m_begin{0};
+  };
+
+  class Phase {
+  public:
+    explicit Phase(uint32_t id)
+    : m_id{id}, m_parent{std::exchange(t_current_phase, id)}, m_begin{phase_counters()}, m_scope{id} {}
+    ~Phase() {
+      if (active()) {
+        phase_done(m_id, m_begin);
+      }
+      t_current_phase = m_parent;
+    }
+
+    Phase(const Phase &) = delete;
+    Phase &operator=(const Phase &) = delete;
+
+  private:
+    // The counters are opened before the clock starts.
+    uint32_t m_id;
+    uint32_t m_parent;
+    PerfCounters::Sample m_begin;
+    Scope m_scope;
+  };
+
+  // Adds this thread's counters, while it lives, to a phase running on
+  // another thread; for pool workers helping out with a batch.
+  class PhaseShare {
+  public:
+    explicit PhaseShare(uint32_t id) : m_id{id}, m_active{id != k_no_scope && active()} {
+      if (m_active) {
+        m_begin = phase_counters();
+      }
+    }
+    ~PhaseShare() {
+      if (m_active) {
+        phase_done(m_id, m_begin);
+      }
+    }
+
+    PhaseShare(const PhaseShare &) = delete;
+    PhaseShare &operator=(const PhaseShare &) = delete;
+
+  private:
+    uint32_t m_id;
+    bool m_active;
+    PerfCounters::Sample m_begin{};
+  };
+
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(name)                                                                                      \
+  static const uint32_t PROFILE_CONCAT(aoc_scope_id_, __LINE__) = ::profile::scope_id(name);                   \
+  ::profile::Scope PROFILE_CONCAT(aoc_scope_, __LINE__) { PROFILE_CONCAT(aoc_scope_id_, __LINE__) }
+
+#define TRACE_PHASE(name)                                                                                      \
+  static const uint32_t PROFILE_CONCAT(aoc_phase_id_, __LINE__) = ::profile::scope_id(name);                   \
+  ::profile::Phase PROFILE_CONCAT(aoc_phase_, __LINE__) { PROFILE_CONCAT(aoc_phase_id_, __LINE__) }
+
+#define COUNTER_ADD(name, n)                                                                                   \
+  do {                                                                                                         \
+    if (::profile::active()) {                                                                                 \
+      static const uint32_t aoc_counter_id = ::profile::counter_id(name);                                      \
+      ::profile::counter_add(aoc_counter_id, (n));                                                             \
+    }                                                                                                          \
+  } while (0)
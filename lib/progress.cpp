@@ -0,0 +1,59 @@
+#include "progress.hpp"
+
+#if !defined(AOC_HEADLESS)
+
+#include "indicators/block_progress_bar.hpp"
+
+using namespace indicators;
+
+Progress::Progress(const std::string &prefix, size_t total, std::chrono::milliseconds redraw_every)
+: m_bar{std::make_unique<BlockProgressBar>(
+      option::PrefixText{prefix},
+      option::BarWidth{60},
+      option::ForegroundColor{Color::yellow},
+      option::ShowElapsedTime{true},
+      option::ShowRemainingTime{true},
+      option::MaxProgress{total})}
+{
+  show_console_cursor(false);
+  if (redraw_every.count() > 0) {
+    m_redraw = std::thread{[this, redraw_every] { redraw_loop(redraw_every); }};
+  }
+}
+
+Progress::~Progress() {
+  finish();
+}
+
+void Progress::draw() {
+  std::lock_guard lock{m_mutex};
+  if (!m_finished) {
+    m_bar->set_progress(static_cast<float>(m_done.load(std::memory_order_relaxed)));
+  }
+}
+
+void Progress::finish() {
+  {
+    std::lock_guard lock{m_mutex};
+    if (m_finished) {
+      return;
+    }
+    m_finished = true;
+  }
+  m_cv.notify_all();
+  if (m_redraw.joinable()) {
+    m_redraw.join();
+  }
+  m_bar->set_progress(static_cast<float>(m_done.load(std::memory_order_relaxed)));
+  m_bar->mark_as_completed();
+  show_console_cursor(true);
+}
+
+void Progress::redraw_loop(std::chrono::milliseconds every) {
+  std::unique_lock lock{m_mutex};
+  while (!m_cv.wait_for(lock, every, [&] { return m_finished; })) {
+    m_bar->set_progress(static_cast<float>(m_done.load(std::memory_order_relaxed)));
+  }
+}
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// A progress bar that costs one relaxed atomic add per tick, so it can sit
+// in hot loops and be ticked from any number of pool threads. A background
+// thread redraws it at a fixed rate; with a zero rate nothing is drawn until
+// draw() is called, for callers that position the cursor themselves.
+//
+// Building with -DAOC_HEADLESS (bazel --config=headless) compiles the whole
+// thing down to empty inline functions.
+#if defined(AOC_HEADLESS)
+
+class Progress {
+public:
+  Progress(const std::string &, size_t, std::chrono::milliseconds = {}) {}
+  void tick(size_t = 1) {}
+  void draw() {}
+  void finish() {}
+};
+
+#else
+
+namespace indicators {
+  class BlockProgressBar;
+}
+
+class Progress {
+public:
+  static constexpr std::chrono::milliseconds k_default_rate{100};
+
+  Progress(const std::string &prefix, size_t total, std::chrono::milliseconds redraw_every = k_default_rate);
+  ~Progress();
+
+  Progress(const Progress &) = delete;
+  Progress &operator=(const Progress &) = delete;
+
+  void tick(size_t n = 1) { m_done.fetch_add(n, std::memory_order_relaxed); }
+  void draw();
+  // Draws the final state and stops redrawing; the destructor calls it too.
+  void finish();
+
+private:
+  void redraw_loop(std::chrono::milliseconds every);
+
+  std::atomic<size_t> m_done{0};
+  std::unique_ptr<indicators::BlockProgressBar> m_bar;
+  std::mutex m_mutex{};
+  std::condition_variable m_cv{};
+  bool m_finished{false};
+  std::thread m_redraw{};
+};
+
+#endif
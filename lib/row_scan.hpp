@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Kernels over contiguous grid rows (grid::Grid::row(), std::string lines,
+// ...). Byte-sized cells are compared 64 at a time with SSE2/AVX2 when the
+// target has them; everything else, and every tail, goes through a scalar loop.
+//
+// Masks are written LSB-first into 64-bit words, one bit per cell, the same
+// layout as a grid::BitGrid row, so a mask can be written straight into
+// BitGrid::row_words().
+namespace grid::scan {
+
+  template <class T>
+  concept ByteCell = sizeof(T) == 1 && std::is_trivially_copyable_v<T>;
+
+  namespace detail {
+    inline uint8_t byte_of(const void *p) {
+      uint8_t b;
+      std::memcpy(&b, p, 1);
+      return b;
+    }
+
+    // Bit i is set when a[i] == b[i], for i in [0, 64).
+    inline uint64_t eq_mask64(const uint8_t *a, const uint8_t *b) {
+#if defined(__AVX2__)
+      auto lo = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a)),
+                                  _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)));
+      auto hi = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 32)),
+                                  _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + 32)));
+      return static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+             (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32);
+#elif defined(__SSE2__)
+      uint64_t result{};
+      for (int i = 0; i < 4; ++i) {
+        auto eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 16 * i)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 16 * i)));
+        result |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq))) << (16 * i);
+      }
+      return result;
+#else
+      uint64_t result{};
+      for (int i = 0; i < 64; ++i) {
+        result |= static_cast<uint64_t>(a[i] == b[i]) << i;
+      }
+      return result;
+#endif
+    }
+
+    // Bit i is set when a[i] == value, for i in [0, 64).
+    inline uint64_t eq_mask64(const uint8_t *a, uint8_t value) {
+#if defined(__AVX2__)
+      auto needle = _mm256_set1_epi8(static_cast<char>(value));
+      auto lo = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a)), needle);
+      auto hi = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 32)), needle);
+      return static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+             (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32);
+#elif defined(__SSE2__)
+      auto needle = _mm_set1_epi8(static_cast<char>(value));
+      uint64_t result{};
+      for (int i = 0; i < 4; ++i) {
+        auto eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 16 * i)), needle);
+        result |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq))) << (16 * i);
+      }
+      return result;
+#else
+      uint64_t result{};
+      for (int i = 0; i < 64; ++i) {
+        result |= static_cast<uint64_t>(a[i] == value) << i;
+      }
+      return result;
+#endif
+    }
+
+    inline const uint8_t *bytes(const void *p) { return static_cast<const uint8_t *>(p); }
+
+    // Mask of up to 64 cells starting at `from`, compared by `eq(i)` one by one.
+    template <typename Eq>
+    uint64_t scalar_mask(size_t from, size_t to, Eq eq) {
+      uint64_t result{};
+      for (size_t i = from; i < to; ++i) {
+        result |= static_cast<uint64_t>(eq(i)) << (i - from);
+      }
+      return result;
+    }
+
+    // Mask of row[i, i + 64) == value, clipped to the row end.
+    template <class T>
+    uint64_t value_mask_at(std::span<const T> row, std::type_identity_t<T> value, size_t i) {
+      if constexpr (ByteCell<T>) {
+        uint8_t needle = byte_of(&value);
+        if (i + 64 <= row.size()) {
+          return eq_mask64(bytes(row.data() + i), needle);
+        }
+        return scalar_mask(i, row.size(), [&](size_t j) { return byte_of(&row[j]) == needle; });
+      } else {
+        return scalar_mask(i, std::min(i + 64, row.size()), [&](size_t j) { return row[j] == value; });
+      }
+    }
+
+    // Mask of a[i, i + 64) == b[i, i + 64), clipped to `size`.
+    template <class T>
+    uint64_t pair_mask_at(std::span<const T> a, std::span<const T> b, size_t size, size_t i) {
+      if constexpr (ByteCell<T>) {
+        if (i + 64 <= size) {
+          return eq_mask64(bytes(a.data() + i), bytes(b.data() + i));
+        }
+        return scalar_mask(i, size, [&](size_t j) { return byte_of(&a[j]) == byte_of(&b[j]); });
+      } else {
+        return scalar_mask(i, std::min(i + 64, size), [&](size_t j) { return a[j] == b[j]; });
+      }
+    }
+  }
+
+  // Number of cells equal to `value`.
+  template <class T>
+  size_t count_equal(std::span<const T> row, std::type_identity_t<T> value) {
+    size_t result{};
+    for (size_t i = 0; i < row.size(); i += 64) {
+      result += std::popcount(detail::value_mask_at(row, value, i));
+    }
+    return result;
+  }
+
+  // out[w] bit b <=> row[64 * w + b] == value. `out` needs (row.size() + 63) / 64 words.
+  template <class T>
+  void equal_mask(std::span<const T> row, std::type_identity_t<T> value, uint64_t *out) {
+    for (size_t i = 0; i < row.size(); i += 64) {
+      out[i / 64] = detail::value_mask_at(row, value, i);
+    }
+  }
+
+  // out[w] bit b <=> a[i] == b[i] for i = 64 * w + b, over the shorter of both rows.
+  // Compare a row against the one above/below it for vertical neighbours.
+  template <class T>
+  void rows_equal_mask(std::span<const T> a, std::span<const T> b, uint64_t *out) {
+    size_t size = std::min(a.size(), b.size());
+    for (size_t i = 0; i < size; i += 64) {
+      out[i / 64] = detail::pair_mask_at(a, b, size, i);
+    }
+  }
+
+  template <class T>
+  size_t count_rows_equal(std::span<const T> a, std::span<const T> b) {
+    size_t size = std::min(a.size(), b.size());
+    size_t result{};
+    for (size_t i = 0; i < size; i += 64) {
+      result += std::popcount(detail::pair_mask_at(a, b, size, i));
+    }
+    return result;
+  }
+
+  // Horizontal neighbours: bit i <=> row[i] == row[i + 1], for i in [0, size - 1).
+  template <class T>
+  void right_neighbour_equal_mask(std::span<const T> row, uint64_t *out) {
+    if (row.empty()) {
+      return;
+    }
+    rows_equal_mask(row.first(row.size() - 1), row.subspan(1), out);
+  }
+
+  // Index of the first cell at or after `from` equal to `value`.
+  template <class T>
+  std::optional<size_t> find_next(std::span<const T> row, std::type_identity_t<T> value, size_t from = 0) {
+    for (size_t i = from; i < row.size(); i += 64) {
+      if (uint64_t mask = detail::value_mask_at(row, value, i)) {
+        return i + std::countr_zero(mask);
+      }
+    }
+    return {};
+  }
+
+  template <class T>
+  std::optional<size_t> find_first(std::span<const T> row, std::type_identity_t<T> value) {
+    return find_next(row, value, 0);
+  }
+
+}
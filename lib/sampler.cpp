@@ -0,0 +1,178 @@
+#include "sampler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+namespace sampler {
+
+  namespace {
+    constexpr int k_max_depth = 128;
+    // The handler and the signal trampoline.
+    constexpr int k_skip_frames = 2;
+    // Samples are stored back to back as [depth, frames...].
+    constexpr size_t k_buffer_words = 1 << 22;
+
+    // Leaked, so late signals never see it freed.
+    uintptr_t *g_buffer = nullptr;
+    std::atomic<size_t> g_used{0};
+    std::atomic<size_t> g_dropped{0};
+    std::atomic<bool> g_running{false};
+    std::string g_out_path{};
+    std::once_flag g_stopped{};
+
+    void on_sigprof(int) {
+      int saved_errno = errno;
+      void *frames[k_max_depth];
+      int depth = ::backtrace(frames, k_max_depth) - k_skip_frames;
+      if (depth > 0) {
+        size_t at = g_used.fetch_add(depth + 1, std::memory_order_relaxed);
+        if (at + depth + 1 <= k_buffer_words) {
+          for (int i = 0; i < depth; ++i) {
+            g_buffer[at + 1 + i] = reinterpret_cast<uintptr_t>(frames[k_skip_frames + i]);
+          }
+          g_buffer[at] = depth;
+        } else {
+          // Full; g_used only grows from here, so every later sample lands
+          // here too.
+          g_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      errno = saved_errno;
+    }
+
+    std::string demangle(const char *name) {
+      int status{0};
+      std::unique_ptr<char, decltype(&std::free)> demangled{abi::__cxa_demangle(name, nullptr, nullptr, &status), &std::free};
+      return status == 0 ? std::string{demangled.get()} : std::string{name};
+    }
+
+    std::string symbolize(uintptr_t addr) {
+      Dl_info info{};
+      if (!::dladdr(reinterpret_cast<void *>(addr), &info)) {
+        return std::format("{:#x}", addr);
+      }
+      std::string name{};
+      if (info.dli_sname) {
+        name = demangle(info.dli_sname);
+      } else {
+        std::string_view module = info.dli_fname ? info.dli_fname : "?";
+        module = module.substr(module.rfind('/') + 1);
+        name = std::format("{}+{:#x}", module, addr - reinterpret_cast<uintptr_t>(info.dli_fbase));
+      }
+      // ';' separates frames in the output.
+      std::ranges::replace(name, ';', ':');
+      return name;
+    }
+
+    void write_folded() {
+      size_t used = std::min(g_used.load(), k_buffer_words);
+      // A region that was claimed but not filled in has depth 0.
+      std::map<std::vector<uintptr_t>, size_t> stacks{};
+      for (size_t at = 0; at < used;) {
+        size_t depth = g_buffer[at];
+        if (depth == 0 || at + 1 + depth > used) {
+          break;
+        }
+        // Root first; every frame but the interrupted one is a return address,
+        // one past the call it belongs to.
+        std::vector<uintptr_t> stack{};
+        for (size_t i = depth; i-- > 0;) {
+          stack.push_back(g_buffer[at + 1 + i] - (i > 0 ? 1 : 0));
+        }
+        ++stacks[std::move(stack)];
+        at += depth + 1;
+      }
+
+      std::unordered_map<uintptr_t, std::string> names{};
+      std::ofstream out{g_out_path};
+      if (!out) {
+        std::cerr << std::format("Can't write samples to '{}'\n", g_out_path);
+        return;
+      }
+      size_t samples{0};
+      for (const auto &[stack, count] : stacks) {
+        const char *sep = "";
+        for (uintptr_t addr : stack) {
+          auto [it, added] = names.try_emplace(addr);
+          if (added) {
+            it->second = symbolize(addr);
+          }
+          out << sep << it->second;
+          sep = ";";
+        }
+        out << " " << count << "\n";
+        samples += count;
+      }
+      std::cerr << std::format("Wrote {} samples ({} dropped) to '{}'\n", samples, g_dropped.load(), g_out_path);
+    }
+
+    [[maybe_unused]] const bool k_started_from_env = [] {
+      const char *path = std::getenv("AOC_SAMPLE");
+      if (!path || !*path) {
+        return false;
+      }
+      const char *us = std::getenv("AOC_SAMPLE_US");
+      if (!start(path, us ? std::atol(us) : 1000)) {
+        return false;
+      }
+      std::atexit(stop);
+      return true;
+    }();
+  }
+
+  bool start(const std::string &out_path, long interval_us) {
+    if (g_running.exchange(true)) {
+      return false;
+    }
+    g_out_path = out_path;
+    g_buffer = new uintptr_t[k_buffer_words]{};
+    // The first backtrace() loads the unwinder, which mustn't happen in the
+    // handler.
+    void *warm_up[1];
+    ::backtrace(warm_up, 1);
+
+    struct sigaction action{};
+    action.sa_handler = on_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGPROF, &action, nullptr);
+
+    interval_us = std::max(interval_us, 1L);
+    itimerval timer{};
+    timer.it_interval.tv_sec = interval_us / 1'000'000;
+    timer.it_interval.tv_usec = interval_us % 1'000'000;
+    timer.it_value = timer.it_interval;
+    return ::setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+  }
+
+  void stop() {
+    if (!g_running.load()) {
+      return;
+    }
+    std::call_once(g_stopped, [] {
+      itimerval timer{};
+      ::setitimer(ITIMER_PROF, &timer, nullptr);
+      ::signal(SIGPROF, SIG_IGN);
+      write_folded();
+    });
+  }
+
+}
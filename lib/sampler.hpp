@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// An in-process sampling profiler: SIGPROF fires every `interval_us` of CPU
+// time used by the process, the handler records the interrupted stack, and
+// at stop (or exit) the samples are written as folded stacks, one
+// "root;...;leaf count" line per distinct stack, ready for flamegraph.pl or
+// speedscope.
+//
+// Every binary linking //lib starts it at startup when AOC_SAMPLE names the
+// output file; AOC_SAMPLE_US sets the interval (default 1000us, though the
+// kernel rounds it up to its tick). Frames are named with dladdr, which only
+// sees exported symbols; //lib:sampler links with -rdynamic for that, and
+// what is left (static functions, lambdas in anonymous namespaces) shows up
+// as module+offset.
+namespace sampler {
+
+  bool start(const std::string &out_path, long interval_us = 1000);
+  // Stops sampling and writes the folded stacks; does nothing if not started.
+  void stop();
+
+}
@@ -0,0 +1,210 @@
+#include "snapshot.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace snapshot {
+
+  namespace {
+    constexpr char k_magic[8] = {'A', 'O', 'C', 'S', 'N', 'A', 'P', '\0'};
+    constexpr size_t k_align = alignof(std::max_align_t);
+
+    struct FileHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t num_sections;
+      uint64_t key;
+      uint64_t size;
+    };
+
+    struct SectionEntry {
+      uint64_t offset;
+      uint64_t count;
+      uint32_t elem_size;
+      uint32_t reserved;
+    };
+
+    size_t align_up(size_t n) {
+      return (n + k_align - 1) / k_align * k_align;
+    }
+
+    template <class T>
+    T read_at(std::span<const std::byte> image, size_t offset) {
+      T result;
+      std::memcpy(&result, image.data() + offset, sizeof(T));
+      return result;
+    }
+  }
+
+  uint64_t hash_input(std::string_view input) {
+    constexpr uint64_t k_prime = 0x100000001b3;
+    uint64_t h = 0xcbf29ce484222325;
+    size_t i = 0;
+    for (; i + 8 <= input.size(); i += 8) {
+      uint64_t word;
+      std::memcpy(&word, input.data() + i, 8);
+      h = (h ^ word) * k_prime;
+    }
+    for (; i < input.size(); ++i) {
+      h = (h ^ static_cast<uint8_t>(input[i])) * k_prime;
+    }
+    return (h ^ input.size()) * k_prime;
+  }
+
+  size_t Builder::add_raw(const void *data, size_t elem_size, size_t count) {
+    const std::byte *begin = static_cast<const std::byte *>(data);
+    m_sections.push_back(Section{
+        std::vector<std::byte>(begin, begin + elem_size * count),
+        static_cast<uint32_t>(elem_size),
+        count,
+      });
+    return m_sections.size() - 1;
+  }
+
+  Snapshot::Snapshot(const Builder &builder, uint64_t key) : m_key{key} {
+    const auto &sections = builder.m_sections;
+    size_t table_end = sizeof(FileHeader) + sections.size() * sizeof(SectionEntry);
+
+    std::vector<SectionEntry> entries{};
+    size_t size = align_up(table_end);
+    for (const auto &section : sections) {
+      entries.push_back(SectionEntry{size, section.count, section.elem_size, 0});
+      size = align_up(size + section.bytes.size());
+    }
+
+    m_owned.resize(size / sizeof(uint64_t));
+    std::byte *out = reinterpret_cast<std::byte *>(m_owned.data());
+
+    FileHeader header{};
+    std::memcpy(header.magic, k_magic, sizeof(k_magic));
+    header.version = k_version;
+    header.num_sections = sections.size();
+    header.key = key;
+    header.size = size;
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), entries.data(), entries.size() * sizeof(SectionEntry));
+    for (size_t i = 0; i < sections.size(); ++i) {
+      std::memcpy(out + entries[i].offset, sections[i].bytes.data(), sections[i].bytes.size());
+    }
+
+    m_image = {out, size};
+    if (!index_sections()) {
+      throw std::logic_error("Freshly built snapshot doesn't validate");
+    }
+  }
+
+  Snapshot::Snapshot(MappedInput file, uint64_t key) : m_file{std::move(file)}, m_key{key} {
+    m_image = std::as_bytes(std::span{m_file->data(), m_file->size()});
+  }
+
+  std::optional<Snapshot> Snapshot::load(const std::string &path, uint64_t key) {
+    if (!std::filesystem::exists(path)) {
+      return {};
+    }
+    Snapshot result{MappedInput::from_file(path), key};
+    if (!result.index_sections()) {
+      return {};
+    }
+    return result;
+  }
+
+  bool Snapshot::index_sections() {
+    m_sections.clear();
+    if (m_image.size() < sizeof(FileHeader)) {
+      return false;
+    }
+    auto header = read_at<FileHeader>(m_image, 0);
+    if (std::memcmp(header.magic, k_magic, sizeof(k_magic)) != 0 ||
+        header.version != k_version || header.key != m_key || header.size != m_image.size()) {
+      return false;
+    }
+    if ((m_image.size() - sizeof(FileHeader)) / sizeof(SectionEntry) < header.num_sections) {
+      return false;
+    }
+
+    for (size_t i = 0; i < header.num_sections; ++i) {
+      auto entry = read_at<SectionEntry>(m_image, sizeof(FileHeader) + i * sizeof(SectionEntry));
+      if (entry.elem_size == 0 || entry.offset % k_align != 0 || entry.offset > m_image.size() ||
+          entry.count > (m_image.size() - entry.offset) / entry.elem_size) {
+        m_sections.clear();
+        return false;
+      }
+      m_sections.push_back(SectionRef{m_image.subspan(entry.offset, entry.count * entry.elem_size), entry.elem_size});
+    }
+    return true;
+  }
+
+  std::span<const std::byte> Snapshot::raw_section(size_t i, size_t elem_size) const {
+    if (i >= m_sections.size()) {
+      throw std::out_of_range(std::format("Snapshot has no section {}", i));
+    }
+    if (m_sections[i].elem_size != elem_size) {
+      throw std::runtime_error(std::format("Snapshot section {} holds {}-byte values, expected {}",
+                                           i, m_sections[i].elem_size, elem_size));
+    }
+    return m_sections[i].bytes;
+  }
+
+  std::vector<std::string_view> Snapshot::strings(size_t i) const {
+    std::span<const uint32_t> offsets = section<uint32_t>(i);
+    std::span<const char> blob = section<char>(i + 1);
+    std::vector<std::string_view> result{};
+    for (size_t s = 0; s + 1 < offsets.size(); ++s) {
+      if (offsets[s] > offsets[s + 1] || offsets[s + 1] > blob.size()) {
+        throw std::runtime_error(std::format("Snapshot string {} in section {} is out of range", s, i));
+      }
+      result.emplace_back(blob.data() + offsets[s], offsets[s + 1] - offsets[s]);
+    }
+    return result;
+  }
+
+  void Snapshot::write(const std::string &path) const {
+    // Written next to the target and renamed, so concurrent runs never map a
+    // half-written file.
+    std::filesystem::path target{path};
+    std::filesystem::create_directories(target.parent_path());
+    std::string tmp = std::format("{}.{}.tmp", path, ::getpid());
+    {
+      std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+      out.write(reinterpret_cast<const char *>(m_image.data()), m_image.size());
+      if (!out) {
+        throw std::runtime_error(std::format("Can't write snapshot '{}'", tmp));
+      }
+    }
+    std::filesystem::rename(tmp, target);
+  }
+
+  bool enabled() {
+    const char *dir = std::getenv("AOC_SNAPSHOT_DIR");
+    return dir && *dir;
+  }
+
+  std::optional<std::string> path_for(std::string_view name, uint64_t key) {
+    if (!enabled()) {
+      return {};
+    }
+    return std::format("{}/{}-{:016x}.snap", std::getenv("AOC_SNAPSHOT_DIR"), name, key);
+  }
+
+  Snapshot cached(std::string_view name, std::string_view input,
+                  const std::function<void(Builder &)> &build) {
+    uint64_t key = hash_input(input);
+    std::optional<std::string> path = path_for(name, key);
+    if (path) {
+      if (auto snap = Snapshot::load(*path, key)) {
+        return std::move(*snap);
+      }
+    }
+
+    Builder builder{};
+    build(builder);
+    Snapshot result{builder, key};
+    if (path) {
+      result.write(*path);
+    }
+    return result;
+  }
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "grid.hpp"
+#include "mapped_input.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Versioned binary snapshots of parsed inputs.
+//
+// A snapshot is a flat sequence of sections, each one a typed array of
+// trivially copyable values. Parsers describe their result once through a
+// Builder; readers get spans pointing straight into the snapshot, which is
+// mmapped when it comes from disk, so a cached load costs roughly the page
+// faults of touching the data.
+//
+// Snapshots are only written and read when AOC_SNAPSHOT_DIR is set. Files are
+// keyed by the name passed to cached() and a hash of the raw input text, so
+// an edited input is simply a miss.
+namespace snapshot {
+
+  inline constexpr uint32_t k_version = 1;
+
+  // FNV-1a over 8-byte words; not cryptographic, just cheap and stable.
+  uint64_t hash_input(std::string_view input);
+
+  template <class T>
+  concept Storable = std::is_trivially_copyable_v<T> && alignof(T) <= alignof(std::max_align_t);
+
+  class Snapshot;
+
+  class Builder {
+  public:
+    template <Storable T>
+    size_t add(std::span<const T> values) {
+      return add_raw(values.data(), sizeof(T), values.size());
+    }
+
+    template <Storable T>
+    size_t add(const std::vector<T> &values) { return add(std::span<const T>{values}); }
+
+    template <Storable T>
+    size_t add_value(const T &value) { return add(std::span<const T>{&value, 1}); }
+
+    // Strings are stored as one character blob plus an offsets section, so
+    // they take two section slots; read them back with Snapshot::strings().
+    template <class Range>
+    size_t add_strings(const Range &strings) {
+      std::vector<char> blob{};
+      std::vector<uint32_t> offsets{0};
+      for (std::string_view s : strings) {
+        blob.insert(blob.end(), s.begin(), s.end());
+        offsets.push_back(blob.size());
+      }
+      size_t first = add(offsets);
+      add(blob);
+      return first;
+    }
+
+    size_t num_sections() const { return m_sections.size(); }
+
+  private:
+    friend class Snapshot;
+
+    struct Section {
+      std::vector<std::byte> bytes;
+      uint32_t elem_size;
+      uint64_t count;
+    };
+
+    size_t add_raw(const void *data, size_t elem_size, size_t count);
+
+    std::vector<Section> m_sections{};
+  };
+
+  class Snapshot {
+  public:
+    // Serializes the builder in memory, the same bytes that go to disk.
+    Snapshot(const Builder &builder, uint64_t key);
+
+    // Maps `path` and validates it against `key`. Missing, stale and
+    // malformed files all come back as std::nullopt.
+    static std::optional<Snapshot> load(const std::string &path, uint64_t key);
+
+    void write(const std::string &path) const;
+
+    template <Storable T>
+    std::span<const T> section(size_t i) const {
+      std::span<const std::byte> bytes = raw_section(i, sizeof(T));
+      return {reinterpret_cast<const T *>(bytes.data()), bytes.size() / sizeof(T)};
+    }
+
+    template <Storable T>
+    const T &value(size_t i) const {
+      std::span<const T> values = section<T>(i);
+      if (values.size() != 1) {
+        throw std::runtime_error(std::format("Snapshot section {} holds {} values, expected one", i, values.size()));
+      }
+      return values.front();
+    }
+
+    // Views into the snapshot; they stay valid as long as the snapshot does.
+    std::vector<std::string_view> strings(size_t i) const;
+
+    size_t num_sections() const { return m_sections.size(); }
+    uint64_t key() const { return m_key; }
+    bool is_mapped() const { return m_file && m_file->is_mapped(); }
+
+  private:
+    Snapshot(MappedInput file, uint64_t key);
+
+    bool index_sections();
+    std::span<const std::byte> raw_section(size_t i, size_t elem_size) const;
+
+    struct SectionRef {
+      std::span<const std::byte> bytes;
+      uint32_t elem_size;
+    };
+
+    std::optional<MappedInput> m_file{};
+    // uint64_t keeps the in-memory image aligned like the mapped one.
+    std::vector<uint64_t> m_owned{};
+    std::span<const std::byte> m_image{};
+    uint64_t m_key{0};
+    std::vector<SectionRef> m_sections{};
+  };
+
+  // Whether AOC_SNAPSHOT_DIR is set. Days that can stream their input only
+  // do so when it isn't, since a snapshot is keyed by the whole input.
+  bool enabled();
+
+  // Where `name` would be cached for `input`, or std::nullopt when
+  // AOC_SNAPSHOT_DIR isn't set.
+  std::optional<std::string> path_for(std::string_view name, uint64_t key);
+
+  // Loads the snapshot of `input` saved under `name` if there is one,
+  // otherwise runs `build` on a fresh Builder, saves the result (when
+  // snapshots are enabled) and returns it. Either way callers read the parsed
+  // data back through the same Snapshot accessors. Bump the name's suffix
+  // ("day07.v2") whenever the sections a day stores change.
+  Snapshot cached(std::string_view name, std::string_view input,
+                  const std::function<void(Builder &)> &build);
+
+  // Grids take two sections: {width, height} and the cells in storage order.
+  template <Storable Cell, class Layout>
+  size_t add_grid(Builder &builder, const grid::Grid<Cell, Layout> &g) {
+    size_t first = builder.add_value(Coord2D{g.width(), g.height()});
+    builder.add(g.cells());
+    return first;
+  }
+
+  template <Storable Cell, class Layout = grid::layout::RowMajor>
+  grid::Grid<Cell, Layout> load_grid(const Snapshot &snap, size_t i) {
+    Coord2D size = snap.value<Coord2D>(i);
+    std::span<const Cell> cells = snap.section<Cell>(i + 1);
+    grid::Grid<Cell, Layout> result(size.x, size.y);
+    if (cells.size() != result.cells().size()) {
+      throw std::runtime_error(std::format("Snapshot grid has {} cells, expected {}", cells.size(), result.cells().size()));
+    }
+    std::memcpy(result.cells().data(), cells.data(), cells.size_bytes());
+    return result;
+  }
+
+}
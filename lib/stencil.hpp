@@ -0,0 +1,64 @@
+#pragma once
+
+#include "coord.h"
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Neighbourhood iteration with the offsets baked in at compile time. Every
+// visit is unrolled into straight-line code, nothing is allocated.
+//
+//   stencil::Neighbours4::for_each(c, [&](Coord2D n) { ... });
+//
+// The callback may return void, or bool to stop early: returning false skips
+// the remaining offsets and for_each() returns false too.
+namespace stencil {
+
+  namespace detail {
+    template <typename Fn, typename... Args>
+    constexpr bool invoke_continue(Fn &fn, Args &&...args) {
+      if constexpr (std::is_same_v<std::invoke_result_t<Fn &, Args...>, void>) {
+        fn(std::forward<Args>(args)...);
+        return true;
+      } else {
+        return static_cast<bool>(fn(std::forward<Args>(args)...));
+      }
+    }
+  }
+
+  template <Coord2D... Offsets>
+  struct Stencil {
+    static constexpr size_t k_size = sizeof...(Offsets);
+    static constexpr std::array<Coord2D, k_size> k_offsets{Offsets...};
+
+    static constexpr bool contains(Coord2D delta) {
+      return ((delta.x == Offsets.x && delta.y == Offsets.y) || ...);
+    }
+
+    template <typename Fn>
+    static constexpr bool for_each(Coord2D origin, Fn &&fn) {
+      return (detail::invoke_continue(fn, Coord2D{origin.x + Offsets.x, origin.y + Offsets.y}) && ...);
+    }
+  };
+
+  // Same order as Dir2D::all(): up, right, down, left.
+  using Neighbours4 = Stencil<Coord2D{0, -1}, Coord2D{1, 0}, Coord2D{0, 1}, Coord2D{-1, 0}>;
+
+  // Clockwise from up.
+  using Neighbours8 = Stencil<Coord2D{0, -1}, Coord2D{1, -1}, Coord2D{1, 0}, Coord2D{1, 1},
+                              Coord2D{0, 1}, Coord2D{-1, 1}, Coord2D{-1, 0}, Coord2D{-1, -1}>;
+
+  // Like Neighbours4::for_each, but also hands the direction to the callback:
+  // fn(Dir2D dir, Coord2D neighbour).
+  template <typename Fn>
+  constexpr bool for_each_dir(Coord2D origin, Fn &&fn) {
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+      return (detail::invoke_continue(fn, Dir2D{static_cast<Dir2D::Value>(I)},
+                                      Coord2D{origin.x + Neighbours4::k_offsets[I].x,
+                                              origin.y + Neighbours4::k_offsets[I].y}) && ...);
+    }(std::make_index_sequence<4>{});
+  }
+
+}
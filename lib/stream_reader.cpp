@@ -0,0 +1,156 @@
+#include "stream_reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+  [[noreturn]] void throw_errno(std::string_view what, const std::string &name) {
+    throw std::runtime_error(std::format("{} '{}': {}", what, name, std::strerror(errno)));
+  }
+}
+
+StreamReader StreamReader::from_stdin(size_t chunk_size) {
+  return StreamReader{STDIN_FILENO, false, "<stdin>", chunk_size};
+}
+
+StreamReader StreamReader::from_file(const std::string &path, size_t chunk_size) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw_errno("Can't open", path);
+  }
+  return StreamReader{fd, true, path, chunk_size};
+}
+
+StreamReader::StreamReader(int fd, bool owns_fd, std::string name, size_t chunk_size)
+: m_fd{fd}, m_owns_fd{owns_fd}, m_name{std::move(name)}, m_chunk_size{std::max<size_t>(chunk_size, 1)},
+  m_work(2 * m_chunk_size)
+{
+  for (auto &chunk : m_chunks) {
+    chunk.resize(m_chunk_size);
+  }
+  ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  m_reader = std::thread{[this] { reader_loop(); }};
+}
+
+StreamReader::~StreamReader() {
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_reader.join();
+  if (m_owns_fd) {
+    ::close(m_fd);
+  }
+}
+
+std::optional<std::string_view> StreamReader::next_line() {
+  while (true) {
+    const char *begin = m_work.data() + m_pos;
+    if (const void *eol = std::memchr(begin, '\n', m_len - m_pos)) {
+      size_t len = static_cast<const char *>(eol) - begin;
+      m_pos += len + 1;
+      return std::string_view{begin, len};
+    }
+    if (!refill()) {
+      if (m_pos == m_len) {
+        return {};
+      }
+      // The last line has no '\n'. refill() moved it to the front of m_work,
+      // so `begin` is stale.
+      std::string_view last{m_work.data() + m_pos, m_len - m_pos};
+      m_pos = m_len;
+      return last;
+    }
+  }
+}
+
+bool StreamReader::refill() {
+  if (m_done) {
+    return false;
+  }
+  size_t carry = m_len - m_pos;
+  if (carry > m_chunk_size) {
+    throw std::runtime_error(std::format("A line in '{}' is longer than the {} byte chunk", m_name, m_chunk_size));
+  }
+  std::memmove(m_work.data(), m_work.data() + m_pos, carry);
+  m_pos = 0;
+  m_len = carry;
+
+  std::unique_lock lock{m_mutex};
+  m_cv.wait(lock, [&] { return m_filled > 0 || m_eof || m_error; });
+  if (m_filled == 0) {
+    if (m_error) {
+      std::rethrow_exception(m_error);
+    }
+    m_done = true;
+    return false;
+  }
+  size_t slot = m_next_full;
+  std::memcpy(m_work.data() + m_len, m_chunks[slot].data(), m_chunk_len[slot]);
+  m_len += m_chunk_len[slot];
+  m_next_full = 1 - slot;
+  --m_filled;
+  lock.unlock();
+  m_cv.notify_all();
+  return true;
+}
+
+void StreamReader::reader_loop() {
+  size_t slot = 0;
+  while (true) {
+    {
+      std::unique_lock lock{m_mutex};
+      m_cv.wait(lock, [&] { return m_stop || m_filled < m_chunks.size(); });
+      if (m_stop) {
+        return;
+      }
+    }
+
+    // Only this thread touches a slot until it's counted in m_filled.
+    size_t got{0};
+    try {
+      while (got < m_chunk_size) {
+        ssize_t n = ::read(m_fd, m_chunks[slot].data() + got, m_chunk_size - got);
+        if (n < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throw_errno("Can't read", m_name);
+        }
+        if (n == 0) {
+          break;
+        }
+        got += n;
+      }
+    } catch (...) {
+      std::lock_guard lock{m_mutex};
+      m_error = std::current_exception();
+      m_cv.notify_all();
+      return;
+    }
+
+    {
+      std::lock_guard lock{m_mutex};
+      if (got > 0) {
+        m_chunk_len[slot] = got;
+        ++m_filled;
+      }
+      if (got < m_chunk_size) {
+        m_eof = true;
+      }
+    }
+    m_cv.notify_all();
+    if (got < m_chunk_size) {
+      return;
+    }
+    slot = 1 - slot;
+  }
+}
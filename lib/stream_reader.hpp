@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Line-at-a-time input in bounded memory, for solvers that make a single
+// pass. A background thread reads the next chunk while the caller works
+// through the current one. A line that doesn't end inside a chunk is carried
+// over to the next one, so lines may be as long as a chunk; a longer line is
+// an error. Memory use is four chunks no matter how large the input is.
+//
+// Lines are split like std::getline splits them.
+class StreamReader {
+public:
+  static constexpr size_t k_default_chunk = 1 << 20;
+
+  // Must be called before anything else reads std::cin, like
+  // MappedInput::from_stdin.
+  static StreamReader from_stdin(size_t chunk_size = k_default_chunk);
+  static StreamReader from_file(const std::string &path, size_t chunk_size = k_default_chunk);
+
+  StreamReader(const StreamReader &) = delete;
+  StreamReader &operator=(const StreamReader &) = delete;
+  ~StreamReader();
+
+  // The next line, without its '\n', or std::nullopt after the last one.
+  // The view is only valid until the next call.
+  std::optional<std::string_view> next_line();
+
+  template <class Fn>
+  void for_each_line(Fn &&fn) {
+    while (std::optional<std::string_view> line = next_line()) {
+      fn(*line);
+    }
+  }
+
+private:
+  StreamReader(int fd, bool owns_fd, std::string name, size_t chunk_size);
+
+  // Moves the unfinished line to the front of m_work and appends the next
+  // chunk; false once the input is exhausted.
+  bool refill();
+  void reader_loop();
+
+  int m_fd;
+  bool m_owns_fd;
+  std::string m_name;
+  size_t m_chunk_size;
+
+  // The caller's side: lines are cut out of m_work[m_pos, m_len).
+  std::vector<char> m_work{};
+  size_t m_pos{0};
+  size_t m_len{0};
+  bool m_done{false};
+
+  // Chunks handed over by the reader thread, used round-robin.
+  std::array<std::vector<char>, 2> m_chunks{};
+  std::array<size_t, 2> m_chunk_len{};
+  size_t m_filled{0};
+  size_t m_next_full{0};
+  bool m_eof{false};
+  bool m_stop{false};
+  std::exception_ptr m_error{};
+  std::mutex m_mutex{};
+  std::condition_variable m_cv{};
+  std::thread m_reader{};
+};
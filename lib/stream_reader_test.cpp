@@ -0,0 +1,84 @@
+#include "stream_reader.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+  int failures{0};
+
+  void check(bool ok, std::string_view what) {
+    if (!ok) {
+      std::cerr << "FAILED: " << what << "\n";
+      ++failures;
+    }
+  }
+
+  // A temporary file holding `text`, removed again on destruction.
+  struct TempFile {
+    explicit TempFile(std::string_view text) {
+      char name[] = "/tmp/stream_reader_test.XXXXXX";
+      int fd = ::mkstemp(name);
+      if (fd < 0 || ::write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size())) {
+        throw std::runtime_error("Can't write temp file");
+      }
+      ::close(fd);
+      path = name;
+    }
+    ~TempFile() { std::remove(path.c_str()); }
+
+    std::string path;
+  };
+
+  std::vector<std::string> read_lines(std::string_view text, size_t chunk_size) {
+    TempFile file{text};
+    StreamReader reader = StreamReader::from_file(file.path, chunk_size);
+    std::vector<std::string> lines{};
+    reader.for_each_line([&](std::string_view line) { lines.emplace_back(line); });
+    return lines;
+  }
+
+  void check_lines(std::string_view name, std::string_view text, size_t chunk_size, const std::vector<std::string> &expected) {
+    std::vector<std::string> lines = read_lines(text, chunk_size);
+    check(lines == expected, std::format("{} (chunk {})", name, chunk_size));
+  }
+}
+
+int main() {
+  for (size_t chunk : {4, 8, 64, 1 << 20}) {
+    check_lines("trailing newline", "abc\nlonger\n", chunk, {"abc", "longer"});
+    check_lines("no trailing newline", "abc\nlonger\n" "xyz", chunk, {"abc", "longer", "xyz"});
+    check_lines("empty lines", "\n\na\n\n", chunk, {"", "", "a", ""});
+    check_lines("empty input", "", chunk, {});
+  }
+
+  // The last line has to be moved to the front of the buffer when the
+  // input runs out.
+  check_lines("no trailing newline, moved", "abc\nlonger_final_line", 20, {"abc", "longer_final_line"});
+  check_lines("no trailing newline, moved", "abc\nlonger_final_line", 32, {"abc", "longer_final_line"});
+
+  // "straddles_" starts in the first chunk and ends in the second.
+  check_lines("line straddles a chunk", "ab\nstraddles_\ncd\n", 8, {"ab", "straddles_", "cd"});
+  check_lines("line fills a chunk", "12345678\nab\n", 8, {"12345678", "ab"});
+
+  bool threw{false};
+  try {
+    read_lines("ab\nmuch_longer_than_a_chunk\n", 8);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  check(threw, "line longer than a chunk throws");
+
+  if (failures > 0) {
+    return EXIT_FAILURE;
+  }
+  std::cout << "OK\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "thread_pool.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+namespace {
+  thread_local bool t_in_task{false};
+
+  size_t default_concurrency() {
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    if (const char *env = std::getenv("AOC_THREADS"); env && *env) {
+      size_t requested = std::stoul(env);
+      return std::clamp<size_t>(requested, 1, hardware);
+    }
+    return hardware;
+  }
+}
+
+ThreadPool::ThreadPool(size_t num_workers) {
+  for (size_t i = 0; i < num_workers; ++i) {
+    m_workers.emplace_back([this] { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_work_cv.notify_all();
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+ThreadPool &ThreadPool::shared() {
+  static ThreadPool pool{default_concurrency() - 1};
+  return pool;
+}
+
+void ThreadPool::run(size_t num_tasks, const std::function<void(size_t)> &fn) {
+  if (num_tasks == 0) {
+    return;
+  }
+  if (t_in_task || m_workers.empty() || num_tasks == 1) {
+    for (size_t i = 0; i < num_tasks; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  // One batch at a time; concurrent callers from outside the pool queue up.
+  std::lock_guard run_lock{m_run_mutex};
+  Batch batch{&fn, num_tasks, profile::t_current_phase};
+  {
+    std::lock_guard lock{m_mutex};
+    m_batch = &batch;
+    ++m_generation;
+  }
+  m_work_cv.notify_all();
+
+  work_on(batch);
+
+  {
+    // Workers that picked the batch up may still be between tasks; the batch
+    // lives on this stack frame, so wait for all of them to let go of it.
+    std::unique_lock lock{m_mutex};
+    m_batch = nullptr;
+    m_done_cv.wait(lock, [&] { return batch.active_workers == 0; });
+  }
+
+  if (batch.error) {
+    std::rethrow_exception(batch.error);
+  }
+}
+
+void ThreadPool::work_on(Batch &batch) {
+  bool was_in_task = std::exchange(t_in_task, true);
+  for (size_t i = batch.next.fetch_add(1); i < batch.num_tasks; i = batch.next.fetch_add(1)) {
+    try {
+      (*batch.fn)(i);
+    } catch (...) {
+      std::lock_guard lock{batch.error_mutex};
+      if (!batch.error) {
+        batch.error = std::current_exception();
+      }
+    }
+  }
+  t_in_task = was_in_task;
+}
+
+void ThreadPool::worker_loop() {
+  uint64_t seen_generation{0};
+  while (true) {
+    Batch *batch{nullptr};
+    {
+      std::unique_lock lock{m_mutex};
+      m_work_cv.wait(lock, [&] { return m_stop || (m_batch && m_generation != seen_generation); });
+      if (m_stop) {
+        return;
+      }
+      seen_generation = m_generation;
+      batch = m_batch;
+      ++batch->active_workers;
+    }
+
+    {
+      profile::PhaseShare share{batch->phase};
+      work_on(*batch);
+    }
+
+    {
+      std::lock_guard lock{m_mutex};
+      --batch->active_workers;
+    }
+    m_done_cv.notify_all();
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads running one batch of indexed tasks at a time.
+// The calling thread takes part in the batch, so a pool of N workers runs
+// N + 1 tasks at once; a pool with no workers simply runs everything inline.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t num_workers);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // One worker per hardware thread besides the caller; AOC_THREADS=<n>
+  // caps the total, AOC_THREADS=1 makes everything single-threaded.
+  static ThreadPool &shared();
+
+  // Threads working on a batch, the caller included.
+  size_t concurrency() const { return m_workers.size() + 1; }
+
+  // Calls fn(i) for every i in [0, num_tasks) and returns when all calls are
+  // done. Tasks are handed out in index order but may finish in any order.
+  // If any task throws, the remaining ones still run and the first exception
+  // is rethrown here. Calls made from inside a task run inline.
+  void run(size_t num_tasks, const std::function<void(size_t)> &fn);
+
+private:
+  struct Batch {
+    const std::function<void(size_t)> *fn;
+    size_t num_tasks;
+    // The caller's TRACE_PHASE, which the workers' counters are added to.
+    uint32_t phase;
+    std::atomic<size_t> next{0};
+    size_t active_workers{0};
+    std::mutex error_mutex{};
+    std::exception_ptr error{};
+  };
+
+  void worker_loop();
+  static void work_on(Batch &batch);
+
+  std::vector<std::thread> m_workers{};
+  std::mutex m_run_mutex{};
+  std::mutex m_mutex{};
+  std::condition_variable m_work_cv{};
+  std::condition_variable m_done_cv{};
+  Batch *m_batch{nullptr};
+  uint64_t m_generation{0};
+  bool m_stop{false};
+};
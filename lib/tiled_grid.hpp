@@ -0,0 +1,146 @@
+#pragma once
+
+#include "coord.h"
+
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace grid {
+
+  // Sparse grid that grows in every direction. Space is split into fixed
+  // k_tile_size x k_tile_size tiles which are only allocated once a cell in
+  // them is set, so memory follows the occupied area rather than the bounding
+  // box. References to cells stay valid while the grid grows.
+  template <class Cell>
+  class TiledGrid {
+  public:
+    using value_t = Cell;
+
+    static constexpr int k_tile_bits = 6;
+    static constexpr int k_tile_size = 1 << k_tile_bits;
+
+    void set(Coord2D c, Cell val) {
+      Tile &tile = tile_for(c);
+      auto [lx, ly] = local(c);
+      tile.cells[ly * k_tile_size + lx] = val;
+      if (!(tile.present[ly] & bit(lx))) {
+        tile.present[ly] |= bit(lx);
+        ++m_size;
+      }
+      m_top_left.maybe_update_lower_boundary(c);
+      m_bottom_right.maybe_update_upper_boundary(c);
+    }
+
+    // Cells that were never set read as Cell{} inside the bounding box of the
+    // set cells, and as Cell::out_of_bounds() (when there is one) outside it.
+    Cell operator[](Coord2D c) const {
+      if (const Cell *cell = find(c)) {
+        return *cell;
+      }
+      if constexpr (requires { Cell::out_of_bounds(); }) {
+        if (!is_within_bounds(c)) {
+          return Cell::out_of_bounds();
+        }
+      }
+      return Cell{};
+    }
+
+    const Cell &at(Coord2D c) const {
+      if (const Cell *cell = find(c)) {
+        return *cell;
+      }
+      throw std::out_of_range(std::format("No cell at {}", c));
+    }
+
+    Cell &at(Coord2D c) {
+      return const_cast<Cell &>(std::as_const(*this).at(c));
+    }
+
+    bool contains(Coord2D c) const { return find(c) != nullptr; }
+
+    const Cell *find(Coord2D c) const {
+      auto it = m_tile_index.find(tile_key(c));
+      if (it == m_tile_index.end()) {
+        return nullptr;
+      }
+      const Tile &tile = m_tiles[it->second];
+      auto [lx, ly] = local(c);
+      if (!(tile.present[ly] & bit(lx))) {
+        return nullptr;
+      }
+      return &tile.cells[ly * k_tile_size + lx];
+    }
+
+    bool is_within_bounds(Coord2D c) const {
+      return c.within_bounds(m_top_left, m_bottom_right);
+    }
+
+    // Bounding box of every cell set so far; empty grids have top_left > bottom_right.
+    std::pair<Coord2D, Coord2D> bounds() const { return std::make_pair(m_top_left, m_bottom_right); }
+
+    size_t size() const { return m_size; }
+    size_t tile_count() const { return m_tiles.size(); }
+
+    // Visits every set cell, tile by tile; the order is not row-major across tiles.
+    template <typename Fn>
+    void for_each(Fn fn) const {
+      for (const Tile &tile : m_tiles) {
+        for (int ly = 0; ly < k_tile_size; ++ly) {
+          uint64_t row = tile.present[ly];
+          while (row) {
+            int lx = std::countr_zero(row);
+            fn(Coord2D{tile.origin.x + lx, tile.origin.y + ly}, tile.cells[ly * k_tile_size + lx]);
+            row &= row - 1;
+          }
+        }
+      }
+    }
+
+  private:
+    static_assert(k_tile_size == 64, "presence masks are one uint64_t per tile row");
+
+    struct Tile {
+      Coord2D origin;
+      std::array<uint64_t, k_tile_size> present{};
+      std::array<Cell, k_tile_size * k_tile_size> cells{};
+    };
+
+    static uint64_t bit(int lx) { return uint64_t{1} << lx; }
+
+    static std::pair<int, int> local(Coord2D c) {
+      return {c.x & (k_tile_size - 1), c.y & (k_tile_size - 1)};
+    }
+
+    static uint64_t tile_key(Coord2D c) {
+      // Arithmetic shift floors negative coords onto the right tile.
+      auto tx = static_cast<uint32_t>(c.x >> k_tile_bits);
+      auto ty = static_cast<uint32_t>(c.y >> k_tile_bits);
+      return (uint64_t{ty} << 32) | tx;
+    }
+
+    Tile &tile_for(Coord2D c) {
+      auto [it, inserted] = m_tile_index.try_emplace(tile_key(c), m_tiles.size());
+      if (inserted) {
+        Tile &tile = m_tiles.emplace_back();
+        tile.origin = {c.x & ~(k_tile_size - 1), c.y & ~(k_tile_size - 1)};
+        return tile;
+      }
+      return m_tiles[it->second];
+    }
+
+    Coord2D m_top_left{INT_MAX, INT_MAX};
+    Coord2D m_bottom_right{INT_MIN, INT_MIN};
+    size_t m_size{0};
+    // deque keeps tile addresses stable when new tiles are appended
+    std::deque<Tile> m_tiles{};
+    std::unordered_map<uint64_t, size_t> m_tile_index{};
+  };
+
+}
@@ -0,0 +1,186 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+  namespace {
+    constexpr size_t k_ring_events = 1 << 12;
+    constexpr size_t k_default_failure_dump = 64;
+
+    struct Ring {
+      explicit Ring(size_t thread_no) : thread_no{thread_no} {}
+
+      size_t thread_no;
+      std::unique_ptr<Event[]> events{std::make_unique<Event[]>(k_ring_events)};
+      // Only the owning thread writes; dump() reads.
+      std::atomic<uint64_t> head{0};
+    };
+
+    struct Registry {
+      std::mutex mutex{};
+      std::vector<std::unique_ptr<Ring>> rings{};
+      std::atomic<size_t> failure_dump{k_default_failure_dump};
+      std::terminate_handler next_handler{};
+      std::once_flag hook_installed{};
+    };
+
+    // Leaked on purpose: rings must outlive their threads, and the terminate
+    // hook may run after static destructors.
+    Registry &registry() {
+      static Registry *registry = new Registry{};
+      return *registry;
+    }
+
+    const auto k_start = std::chrono::steady_clock::now();
+
+    thread_local Ring *t_ring = nullptr;
+
+    Ring &this_ring() {
+      if (!t_ring) [[unlikely]] {
+        Registry &reg = registry();
+        std::lock_guard lock{reg.mutex};
+        reg.rings.push_back(std::make_unique<Ring>(reg.rings.size()));
+        t_ring = reg.rings.back().get();
+      }
+      return *t_ring;
+    }
+
+    void on_terminate() {
+      Registry &reg = registry();
+      if (size_t last_n = reg.failure_dump.load(); last_n > 0) {
+        std::cerr << std::format("\n=== Last {} trace events ===\n", last_n);
+        dump(std::cerr, last_n);
+      }
+      if (reg.next_handler) {
+        reg.next_handler();
+      }
+      std::abort();
+    }
+
+    struct Copied {
+      size_t thread_no;
+      Event event;
+    };
+
+    // Copies the ring while its owner may still be recording: slots are read
+    // without synchronization, like a seqlock, and the ones the owner got to
+    // in the meantime are dropped afterwards.
+    __attribute__((no_sanitize("thread")))
+    void copy_ring(const Ring &ring, std::vector<Copied> &out) {
+      uint64_t head = ring.head.load(std::memory_order_acquire);
+      uint64_t first = head > k_ring_events ? head - k_ring_events : 0;
+      size_t copied_from = out.size();
+      for (uint64_t i = first; i < head; ++i) {
+        out.push_back({ring.thread_no, ring.events[i % k_ring_events]});
+      }
+      // The owner is writing slot `after`, which was event `after - k_ring_events`.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint64_t after = ring.head.load(std::memory_order_relaxed);
+      uint64_t overwritten = after + 1 > k_ring_events ? std::min(after + 1 - k_ring_events, head) : 0;
+      if (overwritten > first) {
+        out.erase(out.begin() + copied_from, out.begin() + copied_from + (overwritten - first));
+      }
+    }
+
+    struct EnvRequest {
+      bool all{false};
+      uint32_t mask{0};
+      std::vector<std::string> names{};
+    };
+
+    const EnvRequest &env_request() {
+      static const EnvRequest request = [] {
+        EnvRequest result{};
+        const char *env = std::getenv("AOC_TRACE");
+        if (!env) {
+          return result;
+        }
+        for (auto part : std::views::split(std::string_view{env}, ',')) {
+          std::string name{part.begin(), part.end()};
+          if (name == "all") {
+            result.all = true;
+          } else if (!name.empty() && std::isdigit(static_cast<unsigned char>(name[0]))) {
+            result.mask |= static_cast<uint32_t>(std::stoul(name, nullptr, 0));
+          } else if (!name.empty()) {
+            result.names.push_back(std::move(name));
+          }
+        }
+        return result;
+      }();
+      return request;
+    }
+  }
+
+  void enable(uint32_t categories) {
+    if (categories == 0) {
+      return;
+    }
+    Registry &reg = registry();
+    std::call_once(reg.hook_installed, [&] { reg.next_handler = std::set_terminate(on_terminate); });
+    g_enabled.fetch_or(categories, std::memory_order_relaxed);
+  }
+
+  void disable(uint32_t categories) {
+    g_enabled.fetch_and(~categories, std::memory_order_relaxed);
+  }
+
+  uint32_t define_category(const char *name, uint32_t mask) {
+    const EnvRequest &request = env_request();
+    if (request.all || (request.mask & mask) || std::ranges::find(request.names, name) != request.names.end()) {
+      enable(mask);
+    }
+    return mask;
+  }
+
+  void set_failure_dump(size_t last_n) {
+    registry().failure_dump.store(last_n);
+  }
+
+  Event &next_event() {
+    Ring &ring = this_ring();
+    return ring.events[ring.head.load(std::memory_order_relaxed) % k_ring_events];
+  }
+
+  void commit() {
+    Ring &ring = *t_ring;
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - k_start).count();
+  }
+
+  void dump(std::ostream &os, size_t last_n) {
+    std::vector<Copied> events{};
+    Registry &reg = registry();
+    {
+      std::lock_guard lock{reg.mutex};
+      for (const auto &ring : reg.rings) {
+        copy_ring(*ring, events);
+      }
+    }
+
+    std::ranges::stable_sort(events, {}, [](const Copied &c) { return c.event.ns; });
+    size_t skip = events.size() > last_n ? events.size() - last_n : 0;
+    std::string line{};
+    for (const Copied &c : events | std::views::drop(skip)) {
+      line.clear();
+      c.event.render(c.event.fmt, c.event.payload.data(), line);
+      os << std::format("{:>12.3f}ms [{}] {} \033[90m({}():{})\033[00m\n", c.event.ns / 1e6, c.thread_no, line,
+                        c.event.site->function, c.event.site->line);
+    }
+    os.flush();
+  }
+
+}
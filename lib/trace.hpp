@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iosfwd>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Always-on event tracing. An event is the call site, a timestamp and the raw
+// bytes of its arguments, written into a ring buffer owned by the recording
+// thread; nothing is formatted until the rings are dumped. Recording is
+// gated by runtime categories (the DEBUG_BIT masks), so a disabled event
+// costs one relaxed load.
+//
+// Categories are enabled with trace::enable or with AOC_TRACE, a comma
+// separated list of DEBUG_BIT names, masks, or "all". While anything is
+// enabled, an uncaught exception or other std::terminate dumps the last
+// events to stderr first.
+namespace trace {
+
+  inline std::atomic<uint32_t> g_enabled{0};
+
+  inline bool enabled(uint32_t categories) {
+    return g_enabled.load(std::memory_order_relaxed) & categories;
+  }
+
+  void enable(uint32_t categories);
+  void disable(uint32_t categories);
+
+  // Registers a DEBUG_BIT name, enabling it right away if AOC_TRACE asks for
+  // it. Returns the mask.
+  uint32_t define_category(const char *name, uint32_t mask);
+
+  // Writes the last `last_n` events of all threads, oldest first, formatted
+  // as DPRINT would have printed them. Best called with tracing quiet: an
+  // event overwritten while it is being copied is left out.
+  void dump(std::ostream &os, size_t last_n = SIZE_MAX);
+
+  // How many events the std::terminate hook dumps; 0 turns it off.
+  void set_failure_dump(size_t last_n);
+
+  struct Site {
+    uint32_t categories;
+    const char *function;
+    int line;
+  };
+
+  inline constexpr size_t k_payload = 80;
+
+  using RenderFn = void (*)(std::string_view fmt, const std::byte *payload, std::string &out);
+
+  struct Event {
+    uint64_t ns;
+    const Site *site;
+    RenderFn render;
+    std::string_view fmt;
+    std::array<std::byte, k_payload> payload;
+  };
+
+  // The calling thread's ring slot for the next event; commit() publishes it.
+  Event &next_event();
+  void commit();
+  uint64_t now_ns();
+
+  namespace detail {
+    // Arguments are stored by value if they're trivially copyable and copied
+    // as (truncated) text if they're strings; anything else has to be
+    // formatted by the caller.
+    template <class T>
+    constexpr bool is_text = std::is_convertible_v<const T &, std::string_view>;
+
+    template <class T>
+    using stored_t = std::conditional_t<is_text<T>, std::string, T>;
+
+    template <class T>
+    constexpr size_t fixed_size() {
+      static_assert(is_text<T> || std::is_trivially_copyable_v<T>,
+                    "trace arguments must be trivially copyable or strings");
+      return is_text<T> ? sizeof(uint16_t) : sizeof(T);
+    }
+
+    template <class T>
+    void encode(std::byte *&out, size_t &spare, const T &value) {
+      if constexpr (is_text<T>) {
+        std::string_view text{value};
+        uint16_t len = static_cast<uint16_t>(std::min(text.size(), spare));
+        spare -= len;
+        std::memcpy(out, &len, sizeof(len));
+        std::memcpy(out + sizeof(len), text.data(), len);
+        out += sizeof(len) + len;
+      } else {
+        std::memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+      }
+    }
+
+    template <class T>
+    stored_t<T> decode(const std::byte *&in) {
+      if constexpr (is_text<T>) {
+        uint16_t len;
+        std::memcpy(&len, in, sizeof(len));
+        std::string text{reinterpret_cast<const char *>(in + sizeof(len)), len};
+        in += sizeof(len) + len;
+        return text;
+      } else {
+        std::array<std::byte, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), in, sizeof(T));
+        in += sizeof(T);
+        return std::bit_cast<T>(bytes);
+      }
+    }
+
+    template <class... Args>
+    void render(std::string_view fmt, const std::byte *payload, std::string &out) {
+      // Braced init keeps the decodes in argument order.
+      std::tuple<stored_t<Args>...> values{decode<Args>(payload)...};
+      std::apply([&](auto &...v) { std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(v...)); }, values);
+    }
+  }
+
+  template <class... Args>
+  void record(const Site &site, std::format_string<const Args &...> fmt, const Args &...args) {
+    constexpr size_t fixed = (size_t{0} + ... + detail::fixed_size<Args>());
+    static_assert(fixed <= k_payload, "trace arguments don't fit in an event");
+    Event &event = next_event();
+    event.ns = now_ns();
+    event.site = &site;
+    event.render = &detail::render<std::decay_t<Args>...>;
+    event.fmt = fmt.get();
+    std::byte *out = event.payload.data();
+    size_t spare = k_payload - fixed;
+    (detail::encode(out, spare, args), ...);
+    commit();
+  }
+
+}
+
+#define TRACE_EVENT(flags, ...)                                                                                \
+  do {                                                                                                         \
+    if (::trace::enabled(flags)) [[unlikely]] {                                                                \
+      static constexpr ::trace::Site aoc_trace_site{(flags), __FUNCTION__, __LINE__};                          \
+      ::trace::record(aoc_trace_site, __VA_ARGS__);                                                            \
+    }                                                                                                          \
+  } while (0)